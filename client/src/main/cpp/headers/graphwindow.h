@@ -29,6 +29,9 @@ public:
     void setData2D(const QVector<QVector<double>>& absData2D,
                    const QVector<QVector<double>>& normData2D);
 
+    // Установка кривой ЭПР по азимуту (углы в градусах, ЭПР в дБм²)
+    void setRcsData(const QVector<double>& angles, const QVector<double>& dbsm);
+
     // Установка параметров отображения
     void setFreqBand(int band);
     void setPortraitType(PortraitDimension type);
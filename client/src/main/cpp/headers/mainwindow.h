@@ -157,6 +157,10 @@ private:
     QCheckBox *anglePortraitCheckBox;
     QCheckBox *azimuthPortraitCheckBox;
     QCheckBox *rangePortraitCheckBox;
+    QCheckBox *rcsSweepCheckBox;   // Расчёт ЭПР по азимуту вместо радиопортрета
+    QVector<double> rcsAngles;     // Азимуты кривой ЭПР, град.
+    QVector<double> rcsDbsm;       // ЭПР, дБм²
+    void displayRcs(const QJsonObject &results);
     QString storedResults;
     QComboBox *freqBandComboBox;
     QCheckBox *pplaneCheckBox;
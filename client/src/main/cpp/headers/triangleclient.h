@@ -68,6 +68,7 @@ private:
     bool m_typeLength;
     QJsonObject vectorToJson(const QSharedPointer<const rVect>& vector);
     void processResults(const QJsonObject &results);
+    static QString formatDuration(double seconds);
     int m_reconnectAttempts;
     const int m_maxReconnectAttempts;
     bool m_intentionalDisconnect;
@@ -244,6 +244,53 @@ void GraphWindow::setData(const QVector<double>& x, const QVector<double>& absY,
     qDebug() << "Graph data normY:" << normY;
 }
 
+void GraphWindow::setRcsData(const QVector<double>& angles, const QVector<double>& dbsm) {
+    if (angles.isEmpty() || angles.size() != dbsm.size()) {
+        return;
+    }
+
+    xData = angles;
+    absEoutData = dbsm;
+    normEoutData.clear();
+    isMultidimensional = false;
+
+    absEoutSeries->clear();
+    normEoutSeries->clear();
+    absEoutSeries->setName(tr("ЭПР"));
+
+    // Значения в дБ бывают отрицательными: логарифмическая шкала и normEout не используются
+    normEoutSeries->setVisible(false);
+    normEoutCheckBox->setVisible(false);
+    logScaleCheckBox->setChecked(false);
+    logScaleCheckBox->setVisible(false);
+    absEoutCheckBox->setText(tr("Показать ЭПР"));
+
+    minX = *std::min_element(angles.begin(), angles.end());
+    maxX = *std::max_element(angles.begin(), angles.end());
+    auto minMaxY = std::minmax_element(dbsm.begin(), dbsm.end());
+    minY = *minMaxY.first;
+    maxY = *minMaxY.second;
+
+    QList<QPointF> points;
+    points.reserve(angles.size());
+    for (int i = 0; i < angles.size(); ++i) {
+        points.append(QPointF(angles[i], dbsm[i]));
+    }
+    absEoutSeries->replace(points);
+
+    xAxisTitle = tr("Азимут, град.");
+    yAxisTitle = tr("ЭПР, дБм²");
+    axisX->setTitleText(xAxisTitle);
+    axisY->setTitleText(yAxisTitle);
+
+    updateAxisRanges();
+    initialPlotArea = chart->plotArea();
+
+    sliceControlWidget->setVisible(false);
+    sliceInfoLabel->setVisible(false);
+    setWindowTitle(tr("ЭПР по азимуту"));
+}
+
 void GraphWindow::setData2D(const QVector<QVector<double>>& absData2D, const QVector<QVector<double>>& normData2D) {
     if (absData2D.isEmpty() || normData2D.isEmpty()) {
         return;
@@ -41,6 +41,7 @@ MainWindow::MainWindow(ConnectionManager* connectionManager, QWidget *parent)
     , anglePortraitCheckBox(new QCheckBox("Угломестный", this))
     , azimuthPortraitCheckBox(new QCheckBox("Азимутальный", this))
     , rangePortraitCheckBox(new QCheckBox("Дальностный", this))
+    , rcsSweepCheckBox(new QCheckBox("ЭПР по азимуту", this))
     , storedResults()
     , freqBandComboBox(new QComboBox(this))
     , pplaneCheckBox(new QCheckBox("Включить подстилающую поверхность", this))
@@ -399,10 +400,13 @@ void MainWindow::setupParametersWidget() {
     anglePortraitCheckBox = new QCheckBox("Угломестный", portraitTypeGroupBox);
     azimuthPortraitCheckBox = new QCheckBox("Азимутальный", portraitTypeGroupBox);
     rangePortraitCheckBox = new QCheckBox("Дальностный", portraitTypeGroupBox);
+    rcsSweepCheckBox = new QCheckBox("ЭПР по азимуту", portraitTypeGroupBox);
+    rcsSweepCheckBox->setToolTip("Моностатическая ЭПР на центральной частоте при повороте объекта на 360° (шаг 0.1°)");
 
     portraitTypeLayout->addWidget(anglePortraitCheckBox);
     portraitTypeLayout->addWidget(azimuthPortraitCheckBox);
     portraitTypeLayout->addWidget(rangePortraitCheckBox);
+    portraitTypeLayout->addWidget(rcsSweepCheckBox);
 
     // Группа для поворота
     QGroupBox *rotationGroupBox = new QGroupBox("Поворот", parametersWidget);
@@ -1034,6 +1038,12 @@ void MainWindow::extract3DData(const QJsonArray &array, QVector<QVector<QVector<
 
 // Функция для отображения результатов
 void MainWindow::displayResults(const QJsonObject &results) {
+    // Кривая ЭПР строится сразу, без обработки радиопортрета
+    if (results["content"].toString() == "rcs") {
+        displayRcs(results);
+        return;
+    }
+
     // Копируем необходимые данные перед запуском в другом потоке
     bool angleChecked = anglePortraitCheckBox->isChecked();
     bool azimuthChecked = azimuthPortraitCheckBox->isChecked();
@@ -1046,6 +1056,29 @@ void MainWindow::displayResults(const QJsonObject &results) {
     resultsWatcher->setFuture(future);
 }
 
+// Отображение кривой ЭПР по азимуту
+void MainWindow::displayRcs(const QJsonObject &results) {
+    rcsAngles.clear();
+    rcsDbsm.clear();
+    for (const QJsonValue &value : results["angles"].toArray())
+        rcsAngles.append(value.toDouble());
+    for (const QJsonValue &value : results["rcs_dbsm"].toArray())
+        rcsDbsm.append(value.toDouble());
+
+    if (rcsAngles.isEmpty() || rcsAngles.size() != rcsDbsm.size()) {
+        logMessage("Ошибка: получены некорректные данные ЭПР.");
+        return;
+    }
+    storedResults = QJsonDocument(results).toJson(QJsonDocument::Indented);
+    logMessage(QString("Получена кривая ЭПР: %1 точек.").arg(rcsAngles.size()));
+
+    GraphWindow *graphWindow = new GraphWindow(this);
+    graphWindow->setFreqBand(results["freqBand"].toInt(freqBand));
+    graphWindow->setRcsData(rcsAngles, rcsDbsm);
+    graphWindow->setAttribute(Qt::WA_DeleteOnClose);
+    graphWindow->show();
+}
+
 void MainWindow::processResults(const QJsonObject &results, bool angleChecked, bool azimuthChecked, bool rangeChecked) {
     // Преобразование JSON-объекта в JSON-документ для дальнейшего использования
     QJsonDocument doc(results);
@@ -1180,7 +1213,8 @@ void MainWindow::performCalculation() {
         return;
     }
 
-    if (!anglePortraitCheckBox->isChecked() && !azimuthPortraitCheckBox->isChecked() && !rangePortraitCheckBox->isChecked()) {
+    if (!anglePortraitCheckBox->isChecked() && !azimuthPortraitCheckBox->isChecked() && !rangePortraitCheckBox->isChecked() &&
+        !rcsSweepCheckBox->isChecked()) {
         logMessage("Ошибка: тип радиопортрета не задан. Пожалуйста, выберите хотя бы один тип радиопортрета.");
         showNotification("Тип радиопортрета не задан", Notification::Error);
         return;
@@ -1249,6 +1283,15 @@ void MainWindow::performCalculation() {
     modelData["typeLength"] = typeLength;
     modelData["pplane"] = pplane;
 
+    // Кривая ЭПР по азимуту: сервер поворачивает вектор направления вокруг оси Z
+    if (rcsSweepCheckBox->isChecked()) {
+        QJsonObject rcsSweep;
+        rcsSweep["from"] = -180.0;
+        rcsSweep["to"] = 180.0;
+        rcsSweep["step"] = 0.1;
+        modelData["rcsSweep"] = rcsSweep;
+    }
+
     // Создание JSON-объекта для вектора направления
     QJsonObject directVectorObj;
     directVectorObj["x"] = directVector.getX();
@@ -1679,6 +1722,7 @@ void MainWindow::newProject() {
     anglePortraitCheckBox->setChecked(false);
     azimuthPortraitCheckBox->setChecked(false);
     rangePortraitCheckBox->setChecked(false);
+    rcsSweepCheckBox->setChecked(false);
     pplaneCheckBox->setChecked(false);
     gridCheckBox->setChecked(false);
     freqBandComboBox->setCurrentIndex(5);
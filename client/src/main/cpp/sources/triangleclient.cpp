@@ -174,9 +174,10 @@ void TriangleClient::parseAndProcessMessage(const QString& message) {
     if (obj.contains("type") && obj["type"].isString()) {
         QString type = obj["type"].toString();
 
-        // Обработка типа "result" с содержимым-объектом
-        if (type == "result" && obj["content"].isObject()) {
-            QJsonObject content = obj["content"].toObject();
+        // Обработка типа "result": содержимое передается объектом "content"
+        // либо на верхнем уровне сообщения (content - строка с видом результата)
+        if (type == "result" && (obj["content"].isObject() || obj["content"].isString())) {
+            QJsonObject content = obj["content"].isObject() ? obj["content"].toObject() : obj;
             // qDebug() << "Получены результаты от сервера:" << content;
             // Используем QMetaObject::invokeMethod для передачи данных в основной поток
             QMetaObject::invokeMethod(this, [this, content]() {
@@ -215,12 +216,23 @@ void TriangleClient::parseAndProcessMessage(const QString& message) {
             if (!m_calculationAborted) {
                 int progress = obj["content"].toInt();
                 qDebug() << "Получено обновление прогресс-бара:" << progress;
-                QMetaObject::invokeMethod(this, [this, progress]() {
+                QString text = "Прогресс: " + QString::number(progress) + "%";
+                if (obj.contains("eta") && obj["eta"].isDouble()) {
+                    text += " (осталось ~" + formatDuration(obj["eta"].toDouble()) + ")";
+                }
+                QMetaObject::invokeMethod(this, [this, progress, text]() {
                         emit progressUpdated(progress);
-                        emit logMessage("Прогресс: " + QString::number(progress) + "%");
+                        emit logMessage(text);
                     }, Qt::QueuedConnection);
             }
         }
+        // Обработка типа "estimate" с прогнозом времени расчёта
+        else if (type == "estimate" && obj.contains("seconds") && obj["seconds"].isDouble()) {
+            QString text = "Прогноз времени расчёта: " + formatDuration(obj["seconds"].toDouble());
+            QMetaObject::invokeMethod(this, [this, text]() {
+                    emit logMessage(text);
+                }, Qt::QueuedConnection);
+        }
         // Обработка неизвестного или некорректного типа сообщения
         else {
             qDebug() << "Получен неизвестный или некорректный тип сообщения:" << type;
@@ -379,6 +391,17 @@ void TriangleClient::sendModelData(const QJsonObject &modelData) {
 }
 
 // Обработка полученных результатов с сервера
+QString TriangleClient::formatDuration(double seconds) {
+    qint64 total = qMax<qint64>(0, qRound64(seconds));
+    if (total < 60) {
+        return QString::number(total) + " с";
+    }
+    if (total < 3600) {
+        return QString("%1 мин %2 с").arg(total / 60).arg(total % 60);
+    }
+    return QString("%1 ч %2 мин").arg(total / 3600).arg((total % 3600) / 60);
+}
+
 void TriangleClient::processResults(const QJsonObject &results) {
     qDebug() << "Processing results from server...";
     if (results.contains("content") && results["type"].toString() == "radioportrait") {
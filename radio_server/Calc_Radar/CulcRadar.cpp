@@ -5,6 +5,8 @@
 #include "CulcRadar.h"
 #include "CPUFFT.h"
 #include "VectFFT.h"
+#include "NUFFT.h"
+#include "solver_kernels.h"
 #include "rVect.h"
 #include "rMatrix.h"
 #include <fstream>
@@ -13,13 +15,119 @@
 #include <QFile>
 #include <QJsonDocument>
 #include <QDataStream>
+#include <QSaveFile>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <map>
+#include <tuple>
+#include <limits>
+
+//признак и версия формата файла контрольной точки
+static const quint32 CHECKPOINT_MAGIC = 0x52435054; //"RCPT"
+static const quint32 CHECKPOINT_VERSION = 4;
+//наибольшее число ракурсов в серии
+static const int MAX_ASPECTS = 36000;
+//наибольшее число углов расчета ЭПР
+static const int MAX_RCS_ANGLES = 360000;
+//наибольшее число ракурсов ISAR
+static const int MAX_ISAR_ANGLES = 3600;
+//допустимая относительная погрешность ядра по умолчанию
+static const double DEFAULT_ACCURACY = 1e-9;
+//погрешность ускоренных методов по умолчанию
+static const double ENGINE_ACCURACY = 1e-6;
+//наибольшее число узлов сетки неравномерного fft
+//(узел - 48 байт, при преобразовании по оси сеток две)
+static const double NUFFT_MAX_GRID = 16777216.;
+//разложение амплитуд треугольников для неравномерного fft: не больше
+//NUFFT_MAX_ORDER узлов Чебышева по оси, число узлов выбирается по
+//NUFFT_PROBE_FACETS самым большим треугольникам
+static const int NUFFT_MAX_ORDER = 8;
+static const size_t NUFFT_PROBE_FACETS = 256;
+//взаимное гашение вкладов оценивается прямым суммированием в
+//NUFFT_PROBE_POINTS точках сетки; допуск не меньше NUFFT_MIN_TOLERANCE
+static const size_t NUFFT_PROBE_POINTS = 16;
+static const double NUFFT_MIN_TOLERANCE = 1e-12;
+//кластеры: не более CLUSTER_LEAF треугольников в листе октодерева, не более
+//CLUSTER_POINTS узлов интерполяции по оси, вклад кластера по узлам должен
+//быть в CLUSTER_GAIN раз дешевле прямого
+static const size_t CLUSTER_LEAF = 16;
+static const int CLUSTER_DEPTH = 20;
+static const int CLUSTER_POINTS = 32;
+static const double CLUSTER_GAIN = 2.;
+//треугольники копланарны, если нормали отличаются не более чем на
+//COPLANAR_NORMAL (1 - cos) и вершины удалены от плоскости не более чем на
+//COPLANAR_PHASE / w (фаза вклада меняется не более чем на COPLANAR_PHASE)
+static const double COPLANAR_NORMAL = 1e-10;
+static const double COPLANAR_PHASE = 1e-7;
+//треугольник заменяется криволинейным элементом, если прогиб ребра меняет
+//фазу вклада больше чем на CURVED_PHASE; нормали смежных треугольников,
+//отличающиеся больше чем на CURVED_CREASE (cos), считаются разделенными кромкой
+static const double CURVED_PHASE = 0.01;
+static const double CURVED_CREASE = 0.8;
+//вершины треугольников пары симметрии совпадают с точностью SYMMETRY_TOLERANCE
+//размера модели; пары считаются вместе, если разность фаз их вкладов меньше
+//SYMMETRY_PHASE
+static const double SYMMETRY_TOLERANCE = 1e-9;
+static const double SYMMETRY_PHASE = 1e-6;
+//затенение: OCCLUSION_SAMPLES точек на треугольник, треугольник освещен, если
+//освещена хотя бы половина точек; начало луча смещено по нормали на
+//OCCLUSION_OFFSET размера треугольника; задача потока - OCCLUSION_CHUNK треугольников
+static const int OCCLUSION_SAMPLES = 4;
+static const double OCCLUSION_OFFSET = 1e-6;
+static const size_t OCCLUSION_CHUNK = 1024;
+static const char LIT_DIRECT = 1;
+static const char LIT_REFLECTED = 2;
+//SBR: отражений по умолчанию и лучей на длину волны; при числе лучей больше
+//SBR_MAX_RAYS шаг сетки запуска увеличивается. сетка запуска трассируется
+//полосами не больше SBR_BAND_RAYS лучей; выходы полосы суммируются порциями
+//не меньше SBR_CHUNK выходов, задач суммирования (направлений x порций) не больше SBR_TASKS
+static const int SBR_BOUNCES = 4;
+static const double SBR_DENSITY = 10.;
+static const double SBR_MAX_RAYS = 16777216.;
+static const size_t SBR_BAND_RAYS = 65536;
+static const size_t SBR_CHUNK = 4096;
+static const size_t SBR_TASKS = 256;
+//допуск упрощения модели по умолчанию, длин волн
+static const double DECIMATION_TOLERANCE = 0.1;
+//число порций треугольников при воспроизводимом накоплении (не зависит от числа потоков)
+static const size_t DETERMINISTIC_PARTS = 64;
+//число плиток, пересчитываемых эталонным ядром при пониженной точности
+static const size_t VERIFY_TILES = 8;
+//наибольшее число пикселей изображения ISAR по стороне
+static const int MAX_ISAR_SIZE = 1024;
+//ISAR: профиль дальности ракурса - обратное fft спектра, дополненного нулями в
+//ISAR_PAD раз (до степени двух), обратное проецирование - линейной интерполяцией
+//профиля. точек профилей (ракурсы x отсчеты) не больше ISAR_MAX_SAMPLES,
+//операций обратного проецирования (ракурсы x пиксели) не больше ISAR_MAX_OPS
+static const int ISAR_PAD = 8;
+static const double ISAR_MAX_SAMPLES = 16777216.;
+static const double ISAR_MAX_OPS = 4e9;
+//плитка цикла ФО: число частот одного направления и размер блока треугольников
+//(блок с координатами вершин и поляризационными множителями помещается в L2)
+static const size_t TILE_SAMPLES = 64;
+static const size_t TILE_FACETS = 256;
+//блок частот портрета только по дальности: граница квантов и контрольных точек
+static const size_t RANGE_SAMPLES = 1024;
+//плитка сетки с одной частотой: число направлений
+static const size_t TILE_DIRS = 16;
+
+//поворот вектора вокруг оси Z на угол deg (в градусах)
+static rVect rotate_Z(const rVect &v, double deg)
+{
+    double cosa = cos(deg * Pi / 180.), sina = sin(deg * Pi / 180.);
+    return rVect(v.getX() * cosa - v.getY() * sina,
+                 v.getX() * sina + v.getY() * cosa, v.getZ());
+}
 
 culcradar::culcradar(QObject *parent) : QObject(parent)
 {
     qDebug() <<"Culc_radar constructor";
     progress = 0;
     RUN_C = true;
+    PAUSE_C = false;
     ref = false;
+    dual = false;
     Nin = rVectY;
     Nout = -1 * Nin;
     NinRef = rVectY;
@@ -36,40 +144,176 @@ culcradar::culcradar(QObject *parent) : QObject(parent)
     triangles.clear();
     nodes.clear();
     Ein.setPoint(1., 0., 0.);
+    Ein2.setPoint(0., 0., 1.);
     vEout.clear();
+    vEout2.clear();
     SAVE_MODEL_TO_FILE = false;
     SCAT_FIELD_TO_FILE = false;
     FFT_FIELD_TO_FILE = false;
     RESULT_FROM_FILE = false;
+    CHECKPOINT_INTERVAL = 60000;
+    SLICE_MS = 500;
+    m_start = 0; m_done = 0; m_total = 0;
+    m_stage = 0; m_stages = 1; m_costAhead = 0.;
+    m_polValid = false;
+    m_isarPixel = 0.; m_isarSize = 0;
+    m_kernel = solverKernels::select(DEFAULT_ACCURACY);
+    m_precisionError = -1.;
+    m_deterministic = false;
+    m_nufft = false;
+    m_cluster = false;
+    m_clusterOn = false;
+    m_coplanar = false;
+    m_polygonOn = false;
+    m_curved = false;
+    m_patchOn = false;
+    m_occlusion = false;
+    m_litOn = false;
+    m_litValid = false;
+    m_litShadows = false;
+    m_clientLit = false;
+    m_sbr = false;
+    m_sbrBounces = SBR_BOUNCES;
+    m_sbrDensity = SBR_DENSITY;
+    m_symmetry = false;
+    m_symmetryDeclared = false;
+    m_symmetryOffset = 0.;
+    m_symmetryOn = false;
+    m_symmetryReach = 0.;
+    m_polMirror = false;
+    m_decimation = false;
+    m_decimationTolerance = DECIMATION_TOLERANCE;
+    m_engineTolerance = ENGINE_ACCURACY;
+    dAngleX = 0.; dAngleZ = 0.;
+}
+
+//размерность массива по одной оси
+int culcradar::count_Axis(double L, double step)
+{
+    if (!step)
+        return 1;
+    int count = 2 * L / step;
+    return (int)pad2((unsigned int)count);
 }
 
 //определяем размерности массива
 void culcradar::culc_count()
 {
-    if (stepX)
-        countX =2 * Lmax / stepX;
-    else
-        countX = 1;
-    countX = (int)pad2((unsigned int)countX);
-
+    countX = count_Axis(Lmax, stepX);
+    countY = count_Axis(Lmax, stepY);
     if (stepY)
-    {
-        countY = 2 * Lmax / stepY;
-        countY = (int)pad2((unsigned int)countY);
         stepW = 6. /(1. * countY*stepY);
-    }
-    else
-        countY = 1;
+    countZ = count_Axis(Lmax, stepZ);
+    setSizeEout(countX, countY, countZ);
+}
 
+//переход к следующему диапазону многодиапазонной задачи
+void culcradar::set_Band(int band)
+{
+    radar_wave wave1(band);
+    int inc_polariz = RWave.getIncPolariz();
+    int ref_polariz = RWave.getRefPolariz();
+    rVect pol;
+    wave1.setPolariz(inc_polariz, ref_polariz, Nin, pol); //векторы поляризации не меняются
+    set_wave(2*Pi/wave1.getLambda());
+    set_stepXYZ(wave1.getStepX(), wave1.getStepY(), wave1.getStepZ());
+    RWave = wave1;
+    if (m_decimation) decimate_Model();
+}
 
-    if (stepZ)
-        countZ = 2 * Lmax / stepZ;
-    else
-        countZ = 1;
-    countZ = (int)pad2((unsigned int)countZ);
+//число точек сетки диапазона без перестройки массивов
+size_t culcradar::band_Samples(int band)
+{
+    radar_wave wave1(band);
+    size_t n = 1;
+    if (boolX) n *= count_Axis(Lmax, wave1.getStepX());
+    if (boolY) n *= count_Axis(Lmax, wave1.getStepY());
+    if (boolZ) n *= count_Axis(Lmax, wave1.getStepZ());
+    return n;
+}
+
+//направление падения волны и векторы поляризации для него
+int culcradar::set_Direction(rVect In, int inc_polariz, int ref_polariz)
+{
+    set_Incidence(In);
+    m_clientLit = false; //освещенность из задачи - для другого направления
+    return set_Polariz(inc_polariz, ref_polariz);
+}
+
+//направление падения волны (поляризация не меняется)
+void culcradar::set_Incidence(rVect In)
+{
+    Nin = In;
+    NinRef.setPoint(Nin.getX(), Nin.getY(), -Nin.getZ());
+    Nout.setPoint(-Nin.getX(), -Nin.getY(), -Nin.getZ());
+    NoutRef.setPoint(-Nin.getX(), -Nin.getY(), Nin.getZ());
+    m_polValid = false;
+    m_litValid = false;
+}
+
+//векторы поляризации падающей волны для текущего направления Nin
+int culcradar::set_Polariz(int inc_polariz, int ref_polariz)
+{
+    m_polValid = false;
+    int err = RWave.setPolariz(inc_polariz, ref_polariz, Nin, Ein);
+    if (err > 0)
+        return err;
+    if (dual) {
+        radar_wave pol(RWave);
+        int v = 0, h = 1;
+        pol.setPolariz(v, v, Nin, EinV);
+        pol.setPolariz(h, h, Nin, EinH);
+        Ein2 = (inc_polariz == 0) ? EinH : EinV;
+    }
+    return 0;
+}
+
+//копирование модели и параметров задачи для расчета другого ракурса.
+//узлы модели общие, треугольники копируются вместе с освещенностью
+void culcradar::copy_Model(culcradar &src)
+{
+    ref = src.ref;
+    dual = src.dual;
+    boolX = src.boolX; boolY = src.boolY; boolZ = src.boolZ;
+    Lmax = src.Lmax;
+    stepX = src.stepX; stepY = src.stepY; stepZ = src.stepZ;
+    countX = src.countX; countY = src.countY; countZ = src.countZ;
+    wave = src.wave;
+    stepW = src.stepW;
+    edges = src.edges;
+    triangles = src.triangles;
+    m_decimation = src.m_decimation;
+    m_decimationTolerance = src.m_decimationTolerance;
+    m_modelKey = src.m_modelKey;
+    m_sourceTriangles = src.m_sourceTriangles;
+    m_mesh = src.m_mesh;
+    //BVH строится до копирования, чтобы ядра не строили каждое свое
+    if (src.m_occlusion || src.m_sbr) src.model_Bvh();
+    m_bvh = src.m_bvh;
+    m_occlusion = src.m_occlusion;
+    m_clientLit = src.m_clientLit;
+    m_sbr = src.m_sbr;
+    m_sbrBounces = src.m_sbrBounces;
+    m_sbrDensity = src.m_sbrDensity;
+    nodes = src.nodes;
+    RWave = src.RWave;
+    m_bands = src.m_bands;
+    Nin = src.Nin; NinRef = src.NinRef;
+    Nout = src.Nout; NoutRef = src.NoutRef;
+    Ein = src.Ein; Ein2 = src.Ein2;
+    EinV = src.EinV; EinH = src.EinH;
+    m_kernel = src.m_kernel;
+    m_polValid = false;
+    m_litValid = false;
     setSizeEout(countX, countY, countZ);
 }
 
+//общий прогресс многодиапазонной задачи
+int culcradar::stage_Progress(double p)
+{
+    return (int)((100. * m_stage + p) / m_stages);
+}
+
 void culcradar::built_Ns_in(double phi, double theta)
 {
     double cosphi(cos(phi));
@@ -331,6 +575,8 @@ int culcradar::build_Model(QJsonObject &jsonObject, QHash<uint, node> &Node, QHa
     //заполняем массив треугольников triangles
     size_t size = tri.size();
     triangles.resize(size);
+    m_bvh.reset();
+    m_clientLit = true;
     for (size_t i = 0; i < size; i++) {
         triangles[i].setVisible(n_visible[i]);
         for (int j = 0; j < 3; j++) {
@@ -391,8 +637,120 @@ int culcradar::build_Model(QJsonObject &jsonObject, QHash<uint, node> &Node, QHa
         freqband = jsonObject.value("freqBand").toInt();
         qDebug() << "freqBand:" << freqband;
     }
+    // Многодиапазонная задача: список диапазонов, расчет начинается с первого
+    m_bands.clear();
+    if (jsonObject.contains("freqBands")) {
+        for (const auto& value : jsonObject.value("freqBands").toArray()) {
+            int band = value.toInt(-1);
+            if ((band < 0) || (band > 5)) {
+                qDebug() << "Error: wrong band in 'freqBands':" << band;
+                return 6;
+            }
+            m_bands.push_back(band);
+        }
+        if (m_bands.empty()) {
+            qDebug() << "Error: 'freqBands' is empty";
+            return 6;
+        }
+        freqband = m_bands[0];
+    }
+    else
+        m_bands.push_back(freqband);
     radar_wave wave1(freqband);
 
+    // Ядро расчета: по требуемой точности и возможностям процессора или явно по имени
+    double accuracy = jsonObject.value("accuracy").toDouble(DEFAULT_ACCURACY);
+    //смешанная точность: фазы во float, поле в double
+    if (jsonObject.value("precision").toString() == "float32")
+        accuracy = std::max(accuracy, REDUCED_TOLERANCE);
+    m_kernel = solverKernels::select(accuracy);
+    if (jsonObject.contains("kernel")) {
+        m_kernel = solverKernels::find(jsonObject.value("kernel").toString());
+        if (!m_kernel) {
+            qDebug() << "Error: kernel is not available";
+            m_kernel = solverKernels::select(DEFAULT_ACCURACY);
+            return 7;
+        }
+    }
+    //воспроизводимый расчет (приемочные испытания): побитно одинаковый результат при повторе.
+    //результат векторных ядер зависит от набора команд процессора, поэтому ядро
+    //фиксируется скалярным; явно заданное ядро допускается только скалярное или эталонное
+    m_deterministic = jsonObject.value("deterministic").toBool(false);
+    if (m_deterministic) {
+        if (!jsonObject.contains("kernel"))
+            m_kernel = solverKernels::find("scalar");
+        else if ((QString(m_kernel->name) != "scalar") && (QString(m_kernel->name) != "reference")) {
+            qDebug() << "Error: 'deterministic' requires kernel 'scalar' or 'reference'";
+            m_kernel = solverKernels::select(DEFAULT_ACCURACY);
+            m_deterministic = false;
+            return 7;
+        }
+    }
+    clogs(QString("ядро расчета ") + m_kernel->name + " (процессор: " +
+          solverKernels::isaName(solverKernels::cpuIsa()) + ")", "", "");
+    if (m_deterministic)
+        clogs("воспроизводимое накопление поля", "", "");
+    //ускоренный расчет неравномерным fft или агрегацией кластеров треугольников;
+    //"accuracy" задает его погрешность. при воспроизводимом расчете не применяется:
+    //порядок сумм в них зависит от числа потоков
+    QString engine = jsonObject.value("engine").toString();
+    if (m_deterministic && ((engine == "nufft") || (engine == "cluster"))) {
+        clogs("ускоренный расчет " + engine + " отключен: воспроизводимый расчет", "wrn", "");
+        engine.clear();
+    }
+    m_nufft = (engine == "nufft");
+    m_cluster = (engine == "cluster");
+    m_engineTolerance = jsonObject.value("accuracy").toDouble(ENGINE_ACCURACY);
+    if (m_nufft)
+        clogs("расчет неравномерным fft, погрешность " +
+              QString::number(m_engineTolerance, 'g', 2), "", "");
+    if (m_cluster)
+        clogs("расчет с агрегацией кластеров треугольников, погрешность " +
+              QString::number(m_engineTolerance, 'g', 2), "", "");
+    //"coplanar": true - копланарные треугольники объединяются в многоугольники
+    m_coplanar = jsonObject.value("coplanar").toBool(false);
+    //"curved": true - изогнутые участки считаются криволинейными элементами
+    m_curved = jsonObject.value("curved").toBool(false);
+    //"occlusion": true - затенение треугольников по лучам к источнику,
+    //иначе освещенность из задачи (visibleTriangles)
+    m_occlusion = jsonObject.value("occlusion").toBool(false);
+    //многократные отражения методом SBR: "sbr": true, "sbrBounces" - наибольшее
+    //число отражений, "sbrDensity" - лучей на длину волны по стороне сетки запуска
+    m_sbr = jsonObject.value("sbr").toBool(false);
+    m_sbrBounces = jsonObject.value("sbrBounces").toInt(SBR_BOUNCES);
+    m_sbrDensity = jsonObject.value("sbrDensity").toDouble(SBR_DENSITY);
+    if (m_sbr && ((m_sbrBounces < 2) || (m_sbrDensity <= 0))) {
+        qDebug() << "Error: wrong 'sbrBounces' or 'sbrDensity'";
+        return 10;
+    }
+    //зеркальная симметрия ("symmetry": true): плоскость ищется среди проходящих
+    //через Nin или задается "symmetryPlane": [nx, ny, nz, d]
+    m_symmetry = jsonObject.value("symmetry").toBool(false);
+    m_symmetryDeclared = jsonObject.contains("symmetryPlane");
+    if (m_symmetryDeclared) {
+        QJsonArray plane = jsonObject.value("symmetryPlane").toArray();
+        if (plane.size() == 4)
+            m_symmetryNormal.setPoint(plane[0].toDouble(), plane[1].toDouble(), plane[2].toDouble());
+        double len = m_symmetryNormal.length();
+        if ((plane.size() != 4) || (len == 0.)) {
+            qDebug() << "Error: wrong 'symmetryPlane'";
+            return 9;
+        }
+        m_symmetryNormal = 1. / len * m_symmetryNormal;
+        m_symmetryOffset = plane[3].toDouble() / len;
+        m_symmetry = true;
+    }
+    //упрощение модели: "decimation": true, допуск "decimationTolerance" - доля длины волны
+    m_decimation = jsonObject.value("decimation").toBool(false);
+    m_decimationTolerance = jsonObject.value("decimationTolerance").toDouble(DECIMATION_TOLERANCE);
+    if (m_decimation && (m_decimationTolerance <= 0)) {
+        qDebug() << "Error: wrong 'decimationTolerance'";
+        return 8;
+    }
+
+    // Режим матрицы рассеяния: поле считается сразу для двух поляризаций падающей волны
+    dual = jsonObject.value("scatMatrix").toBool(false);
+
     // Устанавливаем поляризацию
     if (!jsonObject.contains("polarRadiation") || !jsonObject.contains("polarRecive")) {
         qDebug() << "Error: Missing polarization data";
@@ -401,7 +759,8 @@ int culcradar::build_Model(QJsonObject &jsonObject, QHash<uint, node> &Node, QHa
 
     int inc_polariz = jsonObject.value("polarRadiation").toInt();
     int ref_polariz = jsonObject.value("polarRecive").toInt();
-    int err = wave1.setPolariz(inc_polariz, ref_polariz, Nin, Ein);
+    RWave = wave1;
+    int err = set_Polariz(inc_polariz, ref_polariz);
     if (err > 0) {
         qDebug() << "Error in setPolariz, code:" << err;
         return 4;
@@ -409,12 +768,14 @@ int culcradar::build_Model(QJsonObject &jsonObject, QHash<uint, node> &Node, QHa
 
     set_wave(2*Pi/wave1.getLambda());
 
-    // Устанавливаем тип радиопортрета
+    // Устанавливаем тип радиопортрета (размерности массивов поля задаются здесь)
     bool azimuth_radar_image = jsonObject.value("typeAzimut").toBool();
     bool elevation_radar_image = jsonObject.value("typeAngle").toBool();
     bool range_radar_image = jsonObject.value("typeLength").toBool();
 
-    if (!(elevation_radar_image || azimuth_radar_image || range_radar_image)) {
+    //для кривой ЭПР радиопортрет не строится
+    if (!(elevation_radar_image || azimuth_radar_image || range_radar_image) &&
+        !jsonObject.contains("rcsSweep") && !jsonObject.contains("isar")) {
         qDebug() << "Error: No radar portrait type selected";
         return 5;
     }
@@ -444,6 +805,11 @@ int culcradar::build_Model(QJsonObject &jsonObject, QHash<uint, node> &Node, QHa
     if (jsonObject.contains("pplane")) {
         set_ref(jsonObject.value("pplane").toBool());
     }
+    //неравномерное fft отраженную от поверхности волну не считает
+    if (m_nufft && ref) {
+        qDebug() << "Error: 'engine': 'nufft' does not support 'pplane'";
+        return 11;
+    }
 
     // Устанавливаем направление падения волны
     if (!jsonObject.contains("directVector")) {
@@ -457,15 +823,91 @@ int culcradar::build_Model(QJsonObject &jsonObject, QHash<uint, node> &Node, QHa
     double z = qdirectv.value("z").toDouble();
 
     rVect In(x, y, z);
-    Nin = In;
-    rVect Ref(Nin.getX(), Nin.getY(), -Nin.getZ());
-    NinRef = Ref;
-    rVect Out(-Nin.getX(), -Nin.getY(), -Nin.getZ());
-    rVect OutRef(-Nin.getX(), -Nin.getY(), Nin.getZ());
-    Nout = Out;
-    NoutRef = OutRef;
 
-    RWave = wave1;
+    // Серия ракурсов: список направлений или поворот directVector по азимуту (в градусах)
+    m_aspects.clear();
+    if (jsonObject.contains("directVectors")) {
+        for (const auto& value : jsonObject.value("directVectors").toArray()) {
+            QJsonObject v = value.toObject();
+            rVect aspect(v.value("x").toDouble(), v.value("y").toDouble(), v.value("z").toDouble());
+            if (aspect.length() == 0.) {
+                qDebug() << "Error: zero vector in 'directVectors'";
+                return 3;
+            }
+            m_aspects.push_back(aspect);
+        }
+    }
+    else if (jsonObject.contains("aspectRange")) {
+        QJsonObject range = jsonObject.value("aspectRange").toObject();
+        double from = range.value("from").toDouble();
+        double to = range.value("to").toDouble();
+        double step = range.value("step").toDouble();
+        if ((step <= 0) || (to < from) || ((to - from) / step > MAX_ASPECTS)) {
+            qDebug() << "Error: wrong 'aspectRange'";
+            return 3;
+        }
+        for (double a = from; a <= to + 1e-9; a += step)
+            m_aspects.push_back(rotate_Z(In, a));
+    }
+
+    // ЭПР по азимуту: углы поворота directVector вокруг оси Z (в градусах)
+    m_rcsAngles.clear();
+    if (jsonObject.contains("rcsSweep")) {
+        QJsonObject range = jsonObject.value("rcsSweep").toObject();
+        double from = range.value("from").toDouble();
+        double to = range.value("to").toDouble();
+        double step = range.value("step").toDouble();
+        if ((step <= 0) || (to < from) || ((to - from) / step > MAX_RCS_ANGLES)) {
+            qDebug() << "Error: wrong 'rcsSweep'";
+            return 3;
+        }
+        for (double a = from; a <= to + 1e-9; a += step)
+            m_rcsAngles.push_back(a);
+    }
+
+    // ISAR: азимуты ракурсов (в градусах), размер пикселя и число пикселей по стороне
+    m_isarAngles.clear();
+    if (jsonObject.contains("isar")) {
+        QJsonObject range = jsonObject.value("isar").toObject();
+        double from = range.value("from").toDouble();
+        double to = range.value("to").toDouble();
+        double step = range.value("step").toDouble();
+        if ((step <= 0) || (to <= from) || ((to - from) / step > MAX_ISAR_ANGLES)) {
+            qDebug() << "Error: wrong 'isar'";
+            return 3;
+        }
+        for (double a = from; a <= to + 1e-9; a += step)
+            m_isarAngles.push_back(a);
+        //по умолчанию пиксель - половина разрешения по дальности, кадр - размер модели
+        m_isarPixel = range.value("pixel").toDouble(wave1.getStepY() / 2.);
+        if (m_isarPixel <= 0) {
+            qDebug() << "Error: wrong 'isar' pixel";
+            return 3;
+        }
+        m_isarSize = range.value("size").toInt((int)ceil(Lmax / m_isarPixel));
+        if ((m_isarSize < 1) || (m_isarSize > MAX_ISAR_SIZE)) {
+            qDebug() << "Error: wrong 'isar' size";
+            return 3;
+        }
+        //память профилей и время обратного проецирования
+        double nA = m_isarAngles.size();
+        double profile = pad2(count_Axis(Lmax, wave1.getStepY()) * ISAR_PAD) + 1;
+        if ((nA * profile > ISAR_MAX_SAMPLES) || (nA * m_isarSize * m_isarSize > ISAR_MAX_OPS)) {
+            qDebug() << "Error: 'isar' is too expensive (angles x frequencies or angles x pixels)";
+            return 3;
+        }
+    }
+
+    set_Incidence(In);
+
+    //упрощение модели для первого диапазона (для остальных - в set_Band)
+    m_mesh.reset();
+    m_sourceTriangles.clear();
+    if (m_decimation) {
+        m_sourceTriangles = triangles;
+        m_modelKey = meshDecimation::modelKey(m_sourceTriangles);
+        decimate_Model();
+    }
 
     //Запись модели в json-файл
     if (SAVE_MODEL_TO_FILE) {
@@ -546,18 +988,2035 @@ void culcradar::setEout(size_t iX, size_t iY, size_t iZ, cVect Eout)
 
 void culcradar::setSizeEout(size_t iX, size_t iY, size_t iZ)
 {
-    vEout.resize(iZ);
-    for (int iz = 0; (size_t)iz < iZ; iz++)
+    //массив заполняется нулями: при смене диапазона поле предыдущего не сохраняется
+    vEout.assign(iZ, vector<vector<cVect>>(iY, vector<cVect>(iX)));
+    if (dual) vEout2 = vEout;
+    else vEout2.clear();
+}
+
+//поля, заполняемые в текущем режиме: в режиме матрицы рассеяния их два
+cFields culcradar::culc_Fields()
+{
+    cFields fields;
+    fields.push_back(&vEout);
+    if (dual) fields.push_back(&vEout2);
+    return fields;
+}
+
+//поляризационные множители треугольников для направления рассеяния.
+//множитель не зависит от направления падения и частоты, поэтому для
+//подстилающей поверхности их два (Nout, NoutRef), а по частотам они общие.
+//множители остаются от прошлого вызова и прошлых диапазонов задачи, если
+//направление то же; от диапазона зависит только сложение пар симметрии
+void culcradar::culc_Polariz(rVect &Nout_, rVect &NoutRef_)
+{
+    //направление в плоскости симметрии: отраженный треугольник пары не
+    //считается, его множитель добавляется к множителю пары
+    double wmax = wave + 0.5 * (countY - 1) * fabs(stepW);
+    bool mirror = m_symmetryOn && !m_clusterOn &&
+                  (fabs((Nin - Nout_) * m_symmetryNormal) * 2 * wmax * m_symmetryReach <= SYMMETRY_PHASE);
+    if (m_polValid && (mirror == m_polMirror) && (Nout_ == m_polDir))
+        return;
+    m_polMirror = mirror;
+    size_t size = triangles.size();
+    for (int p = 0; p < 2; p++)
+        for (int d = 0; d < 2; d++)
+            m_pol[p][d].resize(size);
+    for (size_t iTr = 0; iTr < size; iTr++)
+    {
+        if (!triangles[iTr].getVisible()) continue;
+        m_pol[0][0][iTr] = triangles[iTr].CulcPolarization(Nin, Nout_, Ein);
+        if (ref) m_pol[0][1][iTr] = triangles[iTr].CulcPolarization(Nin, NoutRef_, Ein);
+        if (dual)
+        {
+            m_pol[1][0][iTr] = triangles[iTr].CulcPolarization(Nin, Nout_, Ein2);
+            if (ref) m_pol[1][1][iTr] = triangles[iTr].CulcPolarization(Nin, NoutRef_, Ein2);
+        }
+    }
+    if (m_polMirror)
+        for (const std::pair<size_t, size_t> &pair : m_mirrorPairs)
+            for (int p = 0; p < (dual ? 2 : 1); p++)
+                for (int d = 0; d < (ref ? 2 : 1); d++)
+                    m_pol[p][d][pair.first] = m_pol[p][d][pair.first] + m_pol[p][d][pair.second];
+    m_polDir = Nout_;
+    m_polValid = true;
+}
+
+//направление рассеяния для точки сетки (угол, угол)
+void culcradar::culc_Direction(size_t ix, size_t iz, rVect &Nout_, rVect &NoutRef_)
+{
+    Nout_ = culc_Direction((1. * ix - 0.5 * (countX - 1)) * dAngleX,
+                           (1. * iz - 0.5 * (countZ - 1)) * dAngleZ);
+    NoutRef_ = Nout_;  NoutRef_.setZ(-Nout_.getZ());
+}
+
+rVect culcradar::culc_Direction(double ax, double az)
+{
+    rVect Nout_;
+    Nout_.fromSphera(1., 0.5 * Pi + ax, 0.5 * Pi + az);
+    return -1.*(SO2 * Nout_);
+}
+
+//вычисление поля по ФО в плитке: n частот одного направления, начиная с точки
+//m = iy + countY * (ix + countX * iz). треугольники обходятся блоками по
+//TILE_FACETS, вклад треугольника считается сразу для всех частот плитки
+//(рекуррентно по частоте), поле блока накапливается отдельно и добавляется
+//к полю плитки; так список треугольников читается из памяти один раз на плитку,
+//а не на каждую точку. направление и поляризационные множители
+//пересчитываются только при смене направления (iy = 0)
+template<bool AX, bool AZ, bool REF, bool DUAL>
+void culcradar::culc_Tile(size_t m, size_t n)
+{
+    size_t iy0 = m % countY;
+    size_t a = m / countY;
+    size_t ix = AX ? (AZ ? a % countX : a) : 0;
+    size_t iz = AZ ? (AX ? a / countX : a) : 0;
+    double w0 = wave - (1. * iy0 - 0.5 * (countY - 1)) * stepW;
+
+    rVect Nout_, NoutRef_;
+    if (!m_polValid || (iy0 == 0)) {
+        culc_Direction(ix, iz, Nout_, NoutRef_);
+        culc_Polariz(Nout_, NoutRef_);
+    }
+    Nout_ = m_polDir;
+    NoutRef_ = Nout_;  NoutRef_.setZ(-Nout_.getZ());
+
+    //поле накапливается локально, чтобы прерванная плитка не попала в контрольную точку
+    vector<cVect> E(n), E2(DUAL ? n : 0), P(n), P2(DUAL ? n : 0);
+    for (size_t j = 0; j < n; j++) {
+        E[j] = vEout[iz][iy0 + j][ix];
+        if (DUAL) E2[j] = vEout2[iz][iy0 + j][ix];
+    }
+    vector<complex<double>> dOut(n), dRef(REF ? n : 0), tmp(n);
+    const rVect *pol00 = m_pol[0][0].data();
+    const rVect *pol01 = m_pol[0][1].data();
+    const rVect *pol10 = m_pol[1][0].data();
+    const rVect *pol11 = m_pol[1][1].data();
+    //треугольники агрегируемых кластеров считаются в cluster_Tile,
+    //треугольники многоугольников - по границе многоугольника,
+    //изогнутые треугольники - криволинейными элементами (patch_Sweep)
+    const char *clustered = (!REF && m_clusterOn) ? m_clustered.data() : nullptr;
+    const char *merged = m_polygonOn ? m_merged.data() : nullptr;
+    const char *curved = m_patchOn ? m_curvedFacet.data() : nullptr;
+    const char *mirrored = m_polMirror ? m_mirrorSkip.data() : nullptr;
+    size_t size = triangles.size();
+    for (size_t block = 0; block < size; block += TILE_FACETS)
     {
-        vEout[iz].resize(iY);
-        for (int iy = 0; (size_t)iy < iY; iy++)
-            vEout[iz][iy].resize(iX);
+        if (!RUN_C) return;
+        size_t end = std::min(size, block + TILE_FACETS);
+        std::fill(P.begin(), P.end(), cVect());
+        if (DUAL) std::fill(P2.begin(), P2.end(), cVect());
+        for (size_t iTr = block; iTr < end; iTr++)
+        {
+            triangle &tr = triangles[iTr];
+            if (!tr.getVisible()) continue;
+            if ((clustered && clustered[iTr]) || (merged && merged[iTr])) continue;
+            if ((curved && curved[iTr]) || (mirrored && mirrored[iTr])) continue;
+            //четыре слагаемых метода изображений считаются вместе
+            if (REF && m_litOn)
+                facet_RefSweep(iTr, Nout_, w0, n, dOut.data(), dRef.data(), tmp.data());
+            else if (REF)
+                m_kernel->refSweep(tr, Nin, Nout_, w0, stepW, n, dOut.data(), dRef.data(), tmp.data());
+            else
+                m_kernel->sweep(tr, Nin, Nout_, w0, stepW, n, dOut.data());
+            //вклады с одинаковым направлением рассеяния имеют общий поляризационный множитель
+            for (size_t j = 0; j < n; j++)
+            {
+                P[j] = P[j] + dOut[j] * pol00[iTr];
+                if (REF) P[j] = P[j] + dRef[j] * pol01[iTr];
+                if (DUAL)
+                {
+                    P2[j] = P2[j] + dOut[j] * pol10[iTr];
+                    if (REF) P2[j] = P2[j] + dRef[j] * pol11[iTr];
+                }
+            }
+        }
+        for (size_t j = 0; j < n; j++)
+        {
+            E[j] = E[j] + P[j];
+            if (DUAL) E2[j] = E2[j] + P2[j];
+        }
+    }
+    if (merged) {
+        std::fill(P.begin(), P.end(), cVect());
+        if (DUAL) std::fill(P2.begin(), P2.end(), cVect());
+        for (size_t i = 0; i < m_polygons.size(); i++)
+        {
+            if (!RUN_C) return;
+            polygon &pg = m_polygons[i];
+            size_t iTr = pg.getFacet();
+            if (REF)
+                pg.refSweep(Nin, Nout_, w0, stepW, n, dOut.data(), dRef.data(), tmp.data());
+            else
+                pg.DifractionSweep(Nin, Nout_, w0, stepW, n, dOut.data());
+            for (size_t j = 0; j < n; j++)
+            {
+                P[j] = P[j] + dOut[j] * pol00[iTr];
+                if (REF) P[j] = P[j] + dRef[j] * pol01[iTr];
+                if (DUAL)
+                {
+                    P2[j] = P2[j] + dOut[j] * pol10[iTr];
+                    if (REF) P2[j] = P2[j] + dRef[j] * pol11[iTr];
+                }
+            }
+        }
+        for (size_t j = 0; j < n; j++)
+        {
+            E[j] = E[j] + P[j];
+            if (DUAL) E2[j] = E2[j] + P2[j];
+        }
+    }
+    if (curved) patch_Sweep(0, m_patches.size(), Nout_, w0, n, E, DUAL ? &E2 : nullptr);
+    if (clustered) cluster_Tile(ix, iz, iy0, n, E, DUAL ? &E2 : nullptr);
+    if (!RUN_C) return;
+    Nout = Nout_;
+    NoutRef = NoutRef_;
+    for (size_t j = 0; j < n; j++) {
+        vEout[iz][iy0 + j][ix] = E[j];
+        if (DUAL) vEout2[iz][iy0 + j][ix] = E2[j];
+    }
+}
+
+//выбор варианта ядра по размерности сетки и режиму задачи
+culcradar::tileKernel culcradar::select_Kernel()
+{
+    static const tileKernel kernels[16] = {
+        &culcradar::culc_Tile<false, false, false, false>,
+        &culcradar::culc_Tile<false, false, false, true>,
+        &culcradar::culc_Tile<false, false, true, false>,
+        &culcradar::culc_Tile<false, false, true, true>,
+        &culcradar::culc_Tile<false, true, false, false>,
+        &culcradar::culc_Tile<false, true, false, true>,
+        &culcradar::culc_Tile<false, true, true, false>,
+        &culcradar::culc_Tile<false, true, true, true>,
+        &culcradar::culc_Tile<true, false, false, false>,
+        &culcradar::culc_Tile<true, false, false, true>,
+        &culcradar::culc_Tile<true, false, true, false>,
+        &culcradar::culc_Tile<true, false, true, true>,
+        &culcradar::culc_Tile<true, true, false, false>,
+        &culcradar::culc_Tile<true, true, false, true>,
+        &culcradar::culc_Tile<true, true, true, false>,
+        &culcradar::culc_Tile<true, true, true, true>
+    };
+    int index = ((countX > 1) ? 8 : 0) | ((countZ > 1) ? 4 : 0) | (ref ? 2 : 0) | (dual ? 1 : 0);
+    return kernels[index];
+}
+
+//плитка сетки с одной частотой (countY = 1): n направлений подряд, начиная с
+//точки m = ix + countX * iz. блок из TILE_FACETS треугольников считается для
+//всех направлений плитки, пока он в кэше, поэтому список треугольников
+//читается из памяти один раз на плитку, а не на каждое направление.
+//поляризационные множители считаются по треугольнику блока (m_pol не
+//используется); плитка с направлением в плоскости симметрии считается по
+//направлениям обычной плиткой
+template<bool REF, bool DUAL>
+void culcradar::culc_TileDirs(size_t m, size_t n)
+{
+    vector<size_t> ix(n), iz(n);
+    vector<rVect> out(n), outRef(n);
+    for (size_t k = 0; k < n; k++) {
+        ix[k] = (m + k) % countX;
+        iz[k] = (m + k) / countX;
+        culc_Direction(ix[k], iz[k], out[k], outRef[k]);
+    }
+    if (m_symmetryOn && !m_clusterOn)
+        for (size_t k = 0; k < n; k++)
+            if (fabs((Nin - out[k]) * m_symmetryNormal) * 2 * wave * m_symmetryReach <= SYMMETRY_PHASE) {
+                tileKernel tile = select_Kernel();
+                for (size_t i = 0; (i < n) && RUN_C; i++) (this->*tile)(m + i, 1);
+                return;
+            }
+
+    //поле накапливается локально, чтобы прерванная плитка не попала в контрольную точку
+    vector<cVect> E(n), E2(DUAL ? n : 0), P(n), P2(DUAL ? n : 0);
+    for (size_t k = 0; k < n; k++) {
+        E[k] = vEout[iz[k]][0][ix[k]];
+        if (DUAL) E2[k] = vEout2[iz[k]][0][ix[k]];
+    }
+    complex<double> dOut, dRef, tmp;
+    auto add = [&](triangle &tr, size_t k) {
+        P[k] = P[k] + dOut * tr.CulcPolarization(Nin, out[k], Ein);
+        if (REF) P[k] = P[k] + dRef * tr.CulcPolarization(Nin, outRef[k], Ein);
+        if (DUAL) {
+            P2[k] = P2[k] + dOut * tr.CulcPolarization(Nin, out[k], Ein2);
+            if (REF) P2[k] = P2[k] + dRef * tr.CulcPolarization(Nin, outRef[k], Ein2);
+        }
+    };
+    const char *clustered = (!REF && m_clusterOn) ? m_clustered.data() : nullptr;
+    const char *merged = m_polygonOn ? m_merged.data() : nullptr;
+    const char *curved = m_patchOn ? m_curvedFacet.data() : nullptr;
+    size_t size = triangles.size();
+    for (size_t block = 0; block < size; block += TILE_FACETS)
+    {
+        if (!RUN_C) return;
+        size_t end = std::min(size, block + TILE_FACETS);
+        std::fill(P.begin(), P.end(), cVect());
+        if (DUAL) std::fill(P2.begin(), P2.end(), cVect());
+        for (size_t iTr = block; iTr < end; iTr++)
+        {
+            triangle &tr = triangles[iTr];
+            if (!tr.getVisible()) continue;
+            if ((clustered && clustered[iTr]) || (merged && merged[iTr]) || (curved && curved[iTr])) continue;
+            for (size_t k = 0; k < n; k++) {
+                if (REF && m_litOn)
+                    facet_RefSweep(iTr, out[k], wave, 1, &dOut, &dRef, &tmp);
+                else if (REF)
+                    m_kernel->refSweep(tr, Nin, out[k], wave, stepW, 1, &dOut, &dRef, &tmp);
+                else
+                    m_kernel->sweep(tr, Nin, out[k], wave, stepW, 1, &dOut);
+                add(tr, k);
+            }
+        }
+        for (size_t k = 0; k < n; k++)
+        {
+            E[k] = E[k] + P[k];
+            if (DUAL) E2[k] = E2[k] + P2[k];
+        }
+    }
+    if (merged) {
+        std::fill(P.begin(), P.end(), cVect());
+        if (DUAL) std::fill(P2.begin(), P2.end(), cVect());
+        for (size_t i = 0; i < m_polygons.size(); i++)
+        {
+            if (!RUN_C) return;
+            polygon &pg = m_polygons[i];
+            triangle &tr = triangles[pg.getFacet()];
+            for (size_t k = 0; k < n; k++) {
+                if (REF)
+                    pg.refSweep(Nin, out[k], wave, stepW, 1, &dOut, &dRef, &tmp);
+                else
+                    pg.DifractionSweep(Nin, out[k], wave, stepW, 1, &dOut);
+                add(tr, k);
+            }
+        }
+        for (size_t k = 0; k < n; k++)
+        {
+            E[k] = E[k] + P[k];
+            if (DUAL) E2[k] = E2[k] + P2[k];
+        }
+    }
+    //криволинейные элементы и кластеры - по направлениям
+    for (size_t k = 0; (k < n) && (curved || clustered); k++) {
+        vector<cVect> e(1), e2(DUAL ? 1 : 0);
+        if (curved) patch_Sweep(0, m_patches.size(), out[k], wave, 1, e, DUAL ? &e2 : nullptr);
+        if (clustered) cluster_Tile(ix[k], iz[k], 0, 1, e, DUAL ? &e2 : nullptr);
+        E[k] = E[k] + e[0];
+        if (DUAL) E2[k] = E2[k] + e2[0];
+    }
+    if (!RUN_C) return;
+    Nout = out[n - 1];
+    NoutRef = outRef[n - 1];
+    for (size_t k = 0; k < n; k++) {
+        vEout[iz[k]][0][ix[k]] = E[k];
+        if (DUAL) vEout2[iz[k]][0][ix[k]] = E2[k];
+    }
+}
+
+culcradar::tileKernel culcradar::select_DirsKernel()
+{
+    static const tileKernel kernels[4] = {
+        &culcradar::culc_TileDirs<false, false>,
+        &culcradar::culc_TileDirs<false, true>,
+        &culcradar::culc_TileDirs<true, false>,
+        &culcradar::culc_TileDirs<true, true>
+    };
+    return kernels[(ref ? 2 : 0) | (dual ? 1 : 0)];
+}
+
+//сверка ядра пониженной точности: VERIFY_TILES плиток, равномерно
+//распределенных по сетке, пересчитываются эталонным ядром. погрешность -
+//наибольшее отклонение, отнесенное к наибольшему модулю поля в этих точках
+double culcradar::culc_Verify()
+{
+    size_t size1 = vEout[0][0].size();
+    size_t size2 = vEout[0].size();
+    size_t num = size1 * size2 * vEout.size();
+    size_t n = std::min(TILE_SAMPLES, size2);
+    const solverKernel *kernel = m_kernel;
+    bool clusterOn = m_clusterOn, polygonOn = m_polygonOn;
+    m_kernel = solverKernels::find("reference");
+    m_clusterOn = false;
+    m_polygonOn = false;
+    //криволинейные элементы - уточнение геометрии модели, а не приближение счета: остаются
+    tileKernel tile = select_Kernel();
+    cFields fields = culc_Fields();
+    double err = 0., peak = 0.;
+    for (size_t k = 0; (k < VERIFY_TILES) && RUN_C; k++) {
+        //плитка с начала направления
+        size_t m = k * num / VERIFY_TILES;
+        m -= m % size2;
+        size_t ix = (m / size2) % size1;
+        size_t iz = m / (size2 * size1);
+        //плитка пересчитывается с нуля, значения расчета сохраняются
+        vector<vector<cVect>> saved(fields.size(), vector<cVect>(n));
+        for (size_t f = 0; f < fields.size(); f++)
+            for (size_t j = 0; j < n; j++) {
+                saved[f][j] = (*fields[f])[iz][j][ix];
+                (*fields[f])[iz][j][ix] = cVect();
+            }
+        (this->*tile)(m, n);
+        for (size_t f = 0; f < fields.size(); f++)
+            for (size_t j = 0; j < n; j++) {
+                cVect &E = (*fields[f])[iz][j][ix];
+                if (RUN_C) {
+                    peak = std::max(peak, E.norm());
+                    err = std::max(err, (saved[f][j] - E).norm());
+                }
+                E = saved[f][j];
+            }
+    }
+    m_kernel = kernel;
+    m_clusterOn = clusterOn;
+    m_polygonOn = polygonOn;
+    return (peak > 0.) ? sqrt(err / peak) : 0.;
+}
+
+//компенсированное (Кэхэн) добавление x к sum, c - накопленная поправка
+static inline void kahan_Add(cVect &sum, cVect &c, const cVect &x)
+{
+    cVect y = x - c;
+    cVect t = sum + y;
+    c = (t - sum) - y;
+    sum = t;
+}
+
+//портрет только по дальности: направление одно, поэтому вклад треугольника
+//считается сразу для блока из n частот (ядро m_kernel), а не по точкам сетки.
+//блок - плитка цикла ФО: между блоками кванты, пауза и контрольные точки.
+//треугольники блока делятся на n порций (по стоимости порция равна точке
+//сетки), потоки пула накапливают поле каждый в своем массиве; прерванный
+//блок в поле не записывается
+void culcradar::culc_Range(size_t m, size_t n_)
+{
+    size_t iy0 = m % countY;
+    int n = (int)n_;
+    double w0 = wave - (1. * iy0 - 0.5 * (countY - 1)) * stepW;
+    rVect Nout_, NoutRef_;
+    culc_Direction(0, 0, Nout_, NoutRef_);
+    culc_Polariz(Nout_, NoutRef_);
+    Nout_ = m_polDir;
+    NoutRef_ = Nout_;  NoutRef_.setZ(-Nout_.getZ());
+    Nout = Nout_;
+    NoutRef = NoutRef_;
+    if (m_deterministic) {
+        if (culc_RangeOrdered(iy0, n, Nout_)) range_Clusters(iy0, n);
+        return;
+    }
+
+    int threads = culc_Threads();
+    vector<vector<cVect>> acc(threads, vector<cVect>(n));
+    vector<vector<cVect>> acc2(dual ? threads : 0, vector<cVect>(n));
+    size_t size = triangles.size();
+    //порция - треугольники, многоугольники и криволинейные элементы в той же доле
+    size_t polygons = m_polygonOn ? m_polygons.size() : 0;
+    size_t patches = m_patchOn ? m_patches.size() : 0;
+    bool ok = culc_Parallel(n, threads, [&](size_t part, int thread) {
+        vector<complex<double>> dOut(n), dRef(n), t(n);
+        vector<cVect> &E = acc[thread];
+        auto add = [&](size_t iTr) {
+            for (int j = 0; j < n; j++) {
+                E[j] = E[j] + dOut[j] * m_pol[0][0][iTr];
+                if (ref) E[j] = E[j] + dRef[j] * m_pol[0][1][iTr];
+            }
+            if (!dual) return;
+            vector<cVect> &E2 = acc2[thread];
+            for (int j = 0; j < n; j++) {
+                E2[j] = E2[j] + dOut[j] * m_pol[1][0][iTr];
+                if (ref) E2[j] = E2[j] + dRef[j] * m_pol[1][1][iTr];
+            }
+        };
+        for (size_t iTr = part * size / n; iTr < (part + 1) * size / n; iTr++) {
+            triangle &tr = triangles[iTr];
+            if (!tr.getVisible()) continue;
+            if (m_clusterOn && m_clustered[iTr]) continue;
+            if (m_polygonOn && m_merged[iTr]) continue;
+            if (m_patchOn && m_curvedFacet[iTr]) continue;
+            if (m_polMirror && m_mirrorSkip[iTr]) continue;
+            if (ref)
+                facet_RefSweep(iTr, Nout_, w0, n, dOut.data(), dRef.data(), t.data());
+            else
+                m_kernel->sweep(tr, Nin, Nout_, w0, stepW, n, dOut.data());
+            add(iTr);
+        }
+        for (size_t i = part * polygons / n; i < (part + 1) * polygons / n; i++) {
+            polygon &pg = m_polygons[i];
+            if (ref)
+                pg.refSweep(Nin, Nout_, w0, stepW, n, dOut.data(), dRef.data(), t.data());
+            else
+                pg.DifractionSweep(Nin, Nout_, w0, stepW, n, dOut.data());
+            add(pg.getFacet());
+        }
+        patch_Sweep(part * patches / n, (part + 1) * patches / n, Nout_, w0, n,
+                    E, dual ? &acc2[thread] : nullptr);
+    }, 1);
+    if (!ok) return;
+
+    for (int j = 0; j < n; j++) {
+        cVect E, E2;
+        for (int i = 0; i < threads; i++) {
+            E = E + acc[i][j];
+            if (dual) E2 = E2 + acc2[i][j];
+        }
+        vEout[0][iy0 + j][0] = E;
+        if (dual) vEout2[0][iy0 + j][0] = E2;
+    }
+    range_Clusters(iy0, n);
+}
+
+//вклад агрегированных кластеров в блок портрета по дальности
+bool culcradar::range_Clusters(size_t iy0, int n)
+{
+    if (!m_clusterOn) return true;
+    vector<cVect> E(n), E2(dual ? n : 0);
+    cluster_Tile(0, 0, iy0, n, E, dual ? &E2 : nullptr);
+    for (int j = 0; j < n; j++) {
+        vEout[0][iy0 + j][0] = vEout[0][iy0 + j][0] + E[j];
+        if (dual) vEout2[0][iy0 + j][0] = vEout2[0][iy0 + j][0] + E2[j];
+    }
+    return RUN_C;
+}
+
+//воспроизводимый вариант culc_Range: треугольники делятся на DETERMINISTIC_PARTS
+//порций независимо от числа потоков, каждая порция суммируется одним потоком
+//по порядку, частичные суммы складываются по номеру порции. внутри порции
+//вклады блока из TILE_FACETS треугольников складываются как в culc_Tile,
+//суммы блоков - с компенсацией
+bool culcradar::culc_RangeOrdered(size_t iy0, int n, rVect Nout_)
+{
+    double w0 = wave - (1. * iy0 - 0.5 * (countY - 1)) * stepW;
+    size_t size = triangles.size();
+    size_t parts = std::max<size_t>(1, std::min(DETERMINISTIC_PARTS, size));
+    size_t fields = dual ? 2 : 1;
+    //частичные суммы и поправки порций: [порция][поле][частота]
+    vector<vector<vector<cVect>>> acc(parts, vector<vector<cVect>>(fields, vector<cVect>(n)));
+    vector<vector<vector<cVect>>> comp = acc;
+    size_t polygons = m_polygonOn ? m_polygons.size() : 0;
+    size_t patches = m_patchOn ? m_patches.size() : 0;
+    bool ok = culc_Parallel(parts, culc_Threads(), [&](size_t part, int) {
+        vector<complex<double>> dOut(n), dRef(n), t(n);
+        vector<vector<cVect>> P(fields, vector<cVect>(n));
+        auto add = [&](size_t iTr) {
+            for (size_t f = 0; f < fields; f++)
+                for (int j = 0; j < n; j++) {
+                    P[f][j] = P[f][j] + dOut[j] * m_pol[f][0][iTr];
+                    if (ref) P[f][j] = P[f][j] + dRef[j] * m_pol[f][1][iTr];
+                }
+        };
+        size_t end = (part + 1) * size / parts;
+        for (size_t block = part * size / parts; block < end; block += TILE_FACETS) {
+            for (size_t f = 0; f < fields; f++)
+                std::fill(P[f].begin(), P[f].end(), cVect());
+            for (size_t iTr = block; iTr < std::min(end, block + TILE_FACETS); iTr++) {
+                triangle &tr = triangles[iTr];
+                if (!tr.getVisible()) continue;
+                if (m_clusterOn && m_clustered[iTr]) continue;
+                if (m_polygonOn && m_merged[iTr]) continue;
+                if (m_patchOn && m_curvedFacet[iTr]) continue;
+                if (m_polMirror && m_mirrorSkip[iTr]) continue;
+                if (ref)
+                    facet_RefSweep(iTr, Nout_, w0, n, dOut.data(), dRef.data(), t.data());
+                else
+                    m_kernel->sweep(tr, Nin, Nout_, w0, stepW, n, dOut.data());
+                add(iTr);
+            }
+            for (size_t f = 0; f < fields; f++)
+                for (int j = 0; j < n; j++)
+                    kahan_Add(acc[part][f][j], comp[part][f][j], P[f][j]);
+        }
+        //многоугольники и криволинейные элементы порции - отдельными блоками
+        if (polygons > 0) {
+            for (size_t f = 0; f < fields; f++)
+                std::fill(P[f].begin(), P[f].end(), cVect());
+            for (size_t i = part * polygons / parts; i < (part + 1) * polygons / parts; i++) {
+                polygon &pg = m_polygons[i];
+                if (ref)
+                    pg.refSweep(Nin, Nout_, w0, stepW, n, dOut.data(), dRef.data(), t.data());
+                else
+                    pg.DifractionSweep(Nin, Nout_, w0, stepW, n, dOut.data());
+                add(pg.getFacet());
+            }
+            for (size_t f = 0; f < fields; f++)
+                for (int j = 0; j < n; j++)
+                    kahan_Add(acc[part][f][j], comp[part][f][j], P[f][j]);
+        }
+        if (patches > 0) {
+            for (size_t f = 0; f < fields; f++)
+                std::fill(P[f].begin(), P[f].end(), cVect());
+            patch_Sweep(part * patches / parts, (part + 1) * patches / parts, Nout_, w0, n,
+                        P[0], dual ? &P[1] : nullptr);
+            for (size_t f = 0; f < fields; f++)
+                for (int j = 0; j < n; j++)
+                    kahan_Add(acc[part][f][j], comp[part][f][j], P[f][j]);
+        }
+    }, std::max<size_t>(1, n / parts));
+    if (!ok) return false;
+
+    for (size_t f = 0; f < fields; f++)
+        for (int j = 0; j < n; j++) {
+            cVect E, C;
+            for (size_t part = 0; part < parts; part++)
+                kahan_Add(E, C, acc[part][f][j]);
+            (f ? vEout2 : vEout)[0][iy0 + j][0] = E;
+        }
+    return true;
+}
+
+//узел Чебышева k из p на [-1, 1]; один узел - середина отрезка
+static double cheb_Node(int p, int k)
+{
+    return (p > 1) ? cos(Pi * (k + 0.5) / p) : 0.;
+}
+
+//барицентрические веса интерполяции по p узлам Чебышева в точке t
+static void cheb_Basis(int p, double t, double *l)
+{
+    if (p == 1) {
+        l[0] = 1.;
+        return;
+    }
+    double sum = 0.;
+    for (int k = 0; k < p; k++) {
+        double d = t - cheb_Node(p, k);
+        if (fabs(d) < 1e-14) {
+            std::fill(l, l + p, 0.);
+            l[k] = 1.;
+            return;
+        }
+        l[k] = ((k & 1) ? -1. : 1.) * sin(Pi * (k + 0.5) / p) / d;
+        sum += l[k];
+    }
+    for (int k = 0; k < p; k++) l[k] /= sum;
+}
+
+//расчет всей сетки неравномерным fft (nufft3). поле в точке сетки - сумма
+//по треугольникам c(t)*exp(i*s·r), s = w*(Nin - Nout), r - центр треугольника,
+//t - координаты точки на сетке. амплитуда c (дифракционный интеграл без фазы
+//центра и поляризационный множитель) медленно меняется по сетке и
+//раскладывается по осям сетки в произведение рядов Чебышева: поле - сумма по
+//узлам t_q разложения нескольких nufft с амплитудами c(t_q), умноженных на
+//базисные многочлены. число узлов по оси выбирается по допуску "accuracy":
+//погрешность интерполяции амплитуд самых больших треугольников (от ее
+//размера зависит, как быстро меняется амплитуда) не больше половины допуска,
+//вторая половина - на само преобразование. обе погрешности относятся к сумме
+//модулей вкладов треугольников, а допуск - к пику поля, поэтому допуск
+//уменьшается в отношение пика к сумме модулей (взаимное гашение), оцененное
+//прямым суммированием в нескольких точках сетки. поле все равно сверяется с
+//эталоном после расчета (culc_Scattered). множитель w/(2Pi) учитывается точно
+int culcradar::culc_Nufft()
+{
+    size_t size1 = vEout[0][0].size();
+    size_t size2 = vEout[0].size();
+    size_t size3 = vEout.size();
+    size_t num = size1 * size2 * size3;
+    size_t n[3] = { size1, size2, size3 };
+    //точка сетки с дробными индексами (ix, iy, iz): направление и частота
+    auto point = [&](const double *t, rVect &Nout_, double &w) {
+        Nout_ = culc_Direction((t[0] - 0.5 * (countX - 1)) * dAngleX, (t[2] - 0.5 * (countZ - 1)) * dAngleZ);
+        w = wave - (t[1] - 0.5 * (countY - 1)) * stepW;
+    };
+    //точки s в порядке цикла по сетке: m = iy + size2 * (ix + size1 * iz)
+    vector<rVect> s(num);
+    for (size_t m = 0; m < num; m++) {
+        double t[3] = { 1. * ((m / size2) % size1), 1. * (m % size2), 1. * (m / (size2 * size1)) };
+        rVect Nout_;
+        double w;
+        point(t, Nout_, w);
+        s[m] = w * (Nin - Nout_);
+    }
+    //источники - центры освещенных треугольников
+    vector<rVect> x;
+    vector<size_t> index;
+    for (size_t iTr = 0; iTr < triangles.size(); iTr++) {
+        triangle &tr = triangles[iTr];
+        if (!tr.getVisible()) continue;
+        x.push_back(1. / 3. * (*tr.getV1() + *tr.getV2() + *tr.getV3()));
+        index.push_back(iTr);
+    }
+    cFields fields = culc_Fields();
+    rVect Ein_[2] = { Ein, Ein2 };
+    //амплитуды треугольника j в точке t по полям (без множителя w/wave)
+    auto amplitude = [&](size_t j, const double *t, cVect *c) {
+        rVect Nout_;
+        double w;
+        point(t, Nout_, w);
+        triangle &tr = triangles[index[j]];
+        complex<double> d = tr.Difraction(Nin, Nout_, w) * (wave / w) * exp(-OneI * w * ((Nin - Nout_) * x[j]));
+        for (size_t i = 0; i < fields.size(); i++)
+            c[i] = d * tr.CulcPolarization(Nin, Nout_, Ein_[i]);
+    };
+
+    int threads = culc_Threads();
+    //гашение: наибольшее поле в NUFFT_PROBE_POINTS точках сетки к наибольшей
+    //сумме модулей вкладов в них же
+    size_t points = std::min(num, NUFFT_PROBE_POINTS);
+    vector<double> peak(points), sum(points);
+    if (!culc_Parallel(points, threads, [&](size_t k, int) {
+            size_t m = k * num / points;
+            double t[3] = { 1. * ((m / size2) % size1), 1. * (m % size2), 1. * (m / (size2 * size1)) };
+            cVect e, a[2];
+            for (size_t j = 0; j < x.size(); j++) {
+                amplitude(j, t, a);
+                e = e + exp(OneI * (s[m] * x[j])) * a[0];
+                sum[k] += a[0].length();
+            }
+            peak[k] = e.length();
+        }, 0)) return -1;
+    double sumMax = *std::max_element(sum.begin(), sum.end());
+    double gain = (sumMax > 0.) ? *std::max_element(peak.begin(), peak.end()) / sumMax : 1.;
+    double tol = qMax(NUFFT_MIN_TOLERANCE, m_engineTolerance * gain);
+
+    //треугольники для выбора числа узлов: NUFFT_PROBE_FACETS самых больших
+    vector<size_t> probe(x.size());
+    vector<double> edge(x.size());
+    for (size_t j = 0; j < x.size(); j++) {
+        triangle &tr = triangles[index[j]];
+        rVect v1 = *tr.getV1(), v2 = *tr.getV2(), v3 = *tr.getV3();
+        edge[j] = std::max((v2 - v1).length(), std::max((v3 - v1).length(), (v3 - v2).length()));
+        probe[j] = j;
+    }
+    if (probe.size() > NUFFT_PROBE_FACETS) {
+        std::nth_element(probe.begin(), probe.begin() + NUFFT_PROBE_FACETS, probe.end(),
+                         [&](size_t a, size_t b) { return edge[a] > edge[b]; });
+        probe.resize(NUFFT_PROBE_FACETS);
+    }
+    //число узлов по оси: амплитуды в узлах по оси (остальные оси - в центре сетки)
+    //интерполируются в середины между узлами и в концы отрезка
+    int active = (size1 > 1) + (size2 > 1) + (size3 > 1);
+    double tolAxis = 0.5 * tol / qMax(1, active);
+    int order[3];
+    vector<double> l(NUFFT_MAX_ORDER);
+    for (int d = 0; d < 3; d++) {
+        order[d] = 1;
+        if (n[d] == 1) continue;
+        double half = 0.5 * (n[d] - 1);
+        double err = 0.;
+        for (int p = 1; p <= NUFFT_MAX_ORDER; p++) {
+            order[d] = p;
+            vector<double> probes = { -1., 1. };
+            for (int q = 0; q + 1 < p; q++) probes.push_back(0.5 * (cheb_Node(p, q) + cheb_Node(p, q + 1)));
+            if (p == 1) probes.push_back(0.5);
+            double sumErr = 0., sumAmp = 0.;
+            for (size_t j : probe) {
+                double t[3] = { 0.5 * (size1 - 1), 0.5 * (size2 - 1), 0.5 * (size3 - 1) };
+                vector<cVect> node(p * 2);
+                for (int q = 0; q < p; q++) {
+                    t[d] = half * (1. + cheb_Node(p, q));
+                    amplitude(j, t, &node[2 * q]);
+                }
+                for (double u : probes) {
+                    cheb_Basis(p, u, l.data());
+                    t[d] = half * (1. + u);
+                    cVect exact[2], approx;
+                    amplitude(j, t, exact);
+                    for (int q = 0; q < p; q++) approx = approx + l[q] * node[2 * q];
+                    sumErr += (exact[0] - approx).length();
+                    sumAmp += exact[0].length();
+                }
+            }
+            err = (sumAmp > 0.) ? sumErr / sumAmp : 0.;
+            if (err <= tolAxis) break;
+        }
+        if (err > tolAxis) {
+            clogs("амплитуды треугольников не приближаются с допуском " + QString::number(m_engineTolerance, 'g', 2) +
+                  " по " + QString::number(NUFFT_MAX_ORDER) + " узлам по оси, расчет прямым суммированием", "wrn", "");
+            return 1;
+        }
+    }
+    int terms = order[0] * order[1] * order[2];
+    clogs("неравномерное fft: допуск " + QString::number(tol, 'g', 2) + ", узлов разложения амплитуд " +
+          QString::number(order[0]) + " x " + QString::number(order[1]) + " x " + QString::number(order[2]), "", "");
+
+    nufft3 plan(x, s, 0.5 * tol);
+    if (plan.gridPoints() > NUFFT_MAX_GRID) {
+        clogs("сетка неравномерного fft слишком велика (" + QString::number(plan.gridPoints(), 'g', 3) +
+              " узлов), расчет прямым суммированием", "wrn", "");
+        return 1;
+    }
+    //базисные многочлены по осям в точках сетки: L[d][i * order + q]
+    vector<double> L[3];
+    for (int d = 0; d < 3; d++) {
+        L[d].resize(n[d] * order[d]);
+        for (size_t i = 0; i < n[d]; i++)
+            cheb_Basis(order[d], (n[d] > 1) ? 2. * i / (n[d] - 1) - 1. : 0., &L[d][i * order[d]]);
+    }
+    size_t parts = (num + TILE_SAMPLES - 1) / TILE_SAMPLES;
+    size_t chunks = (x.size() + TILE_FACETS - 1) / TILE_FACETS;
+    vector<vector<cVect>> c(fields.size(), vector<cVect>(x.size()));
+    vector<vector<cVect>> E(fields.size(), vector<cVect>(num));
+    vector<cVect> f(num);
+    for (int q = 0; q < terms; q++) {
+        int q0 = q % order[0], q1 = (q / order[0]) % order[1], q2 = q / (order[0] * order[1]);
+        double t[3] = { 0.5 * (size1 - 1) * (1. + cheb_Node(order[0], q0)),
+                        0.5 * (size2 - 1) * (1. + cheb_Node(order[1], q1)),
+                        0.5 * (size3 - 1) * (1. + cheb_Node(order[2], q2)) };
+        if (!culc_Parallel(chunks, threads, [&](size_t k, int) {
+                cVect a[2];
+                for (size_t j = k * TILE_FACETS; j < std::min(x.size(), (k + 1) * TILE_FACETS); j++) {
+                    amplitude(j, t, a);
+                    for (size_t i = 0; i < fields.size(); i++) c[i][j] = a[i];
+                }
+            }, 0)) return -1;
+        for (size_t i = 0; i < fields.size(); i++) {
+            plan.begin();
+            if (!culc_Parallel(plan.layers(), threads, [&](size_t layer, int) {
+                    plan.spread(c[i], layer);
+                }, 0)) return -1;
+            for (int d = 2; d >= 0; d--) {
+                if (!plan.active(d)) continue;
+                plan.beginAxis(d);
+                if (!culc_Parallel(plan.lines(d), threads, [&](size_t k, int) {
+                        plan.transformLine(d, k);
+                    }, 0)) return -1;
+                plan.endAxis(d);
+            }
+            //прогресс - по точкам сетки
+            if (!culc_Parallel(parts, threads, [&](size_t k, int) {
+                    size_t end = std::min(num, (k + 1) * TILE_SAMPLES);
+                    plan.interpolate(k * TILE_SAMPLES, end, f);
+                    for (size_t m = k * TILE_SAMPLES; m < end; m++) {
+                        size_t ix = (m / size2) % size1, iy = m % size2, iz = m / (size2 * size1);
+                        double b = L[0][ix * order[0] + q0] * L[1][iy * order[1] + q1] * L[2][iz * order[2] + q2];
+                        E[i][m] = E[i][m] + b * f[m];
+                    }
+                }, qMax<size_t>(1, TILE_SAMPLES / (fields.size() * terms)))) return -1;
+        }
+    }
+    for (size_t i = 0; i < fields.size(); i++)
+        for (size_t m = 0; m < num; m++) {
+            double w = wave - (1. * (m % size2) - 0.5 * (countY - 1)) * stepW;
+            (*fields[i])[m / (size2 * size1)][m % size2][(m / size2) % size1] = (w / wave) * E[i][m];
+        }
+    double t[3] = { 0.5 * (size1 - 1), 0.5 * (size2 - 1), 0.5 * (size3 - 1) };
+    double w;
+    point(t, Nout, w);
+    NoutRef = Nout;  NoutRef.setZ(-Nout.getZ());
+    return 0;
+}
+
+//упрощенная модель для диапазона RWave: допуск - доля длины волны. модель
+//берется из памяти по ключу (модель, диапазон, допуск) или строится заново
+void culcradar::decimate_Model()
+{
+    double tolerance = m_decimationTolerance * RWave.getLambda();
+    QString key = m_modelKey + "-" + QString::number(RWave.getBand()) + "-" +
+                  QString::number(m_decimationTolerance);
+    bool cached = false;
+    m_mesh = meshDecimation::get(key, m_sourceTriangles, tolerance, cached);
+    triangles = m_mesh->triangles;
+    m_bvh = std::shared_ptr<const facetBvh>(m_mesh, &m_mesh->bvh);
+    m_polValid = false;
+    m_litValid = false;
+    clogs("упрощение модели (допуск " + QString::number(tolerance, 'g', 3) + " м" +
+          (cached ? QString(", из памяти") : QString()) + "): треугольников " +
+          QString::number(m_mesh->source) + " -> " + QString::number(triangles.size()), "", "");
+}
+
+//объединение смежных копланарных освещенных треугольников в многоугольники.
+//многоугольник растет от первого треугольника через общие ребра (ребро
+//соседа обходится в обратную сторону - нормали согласованы); соседи
+//сравниваются с плоскостью первого треугольника, поэтому слабо изогнутая
+//поверхность не сливается в один многоугольник. граница - ребра, встречное
+//к которым не принадлежит многоугольнику. многоугольник используется, если
+//ребер границы меньше, чем треугольников
+void culcradar::culc_Polygons()
+{
+    m_polygonOn = false;
+    m_polygons.clear();
+    size_t size = triangles.size();
+    m_merged.assign(size, 0);
+    double wmax = wave + 0.5 * (countY - 1) * fabs(stepW);
+    //направленные ребра освещенных треугольников
+    std::map<std::pair<node *, node *>, size_t> owner;
+    for (size_t iTr = 0; iTr < size; iTr++) {
+        triangle &tr = triangles[iTr];
+        if (!tr.getVisible()) continue;
+        if (m_litOn && (m_lit[iTr] != (LIT_DIRECT | LIT_REFLECTED))) continue;
+        node *v[3] = { tr.getV1(), tr.getV2(), tr.getV3() };
+        for (int k = 0; k < 3; k++)
+            owner[std::make_pair(v[k], v[(k + 1) % 3])] = iTr;
+    }
+    vector<long> group(size, -1);
+    size_t merged = 0, edges = 0;
+    for (size_t seed = 0; seed < size; seed++) {
+        if (!triangles[seed].getVisible() || (group[seed] >= 0)) continue;
+        if (m_litOn && (m_lit[seed] != (LIT_DIRECT | LIT_REFLECTED))) continue;
+        rVect n = triangles[seed].culcNormal();
+        rVect p = *triangles[seed].getV1();
+        vector<size_t> members(1, seed);
+        group[seed] = seed;
+        for (size_t i = 0; i < members.size(); i++) {
+            triangle &tr = triangles[members[i]];
+            node *v[3] = { tr.getV1(), tr.getV2(), tr.getV3() };
+            for (int k = 0; k < 3; k++) {
+                auto it = owner.find(std::make_pair(v[(k + 1) % 3], v[k]));
+                if ((it == owner.end()) || (group[it->second] >= 0)) continue;
+                triangle &nb = triangles[it->second];
+                if (1. - nb.culcNormal() * n > COPLANAR_NORMAL) continue;
+                double h = std::max(fabs(n * (*nb.getV1() - p)),
+                                    std::max(fabs(n * (*nb.getV2() - p)), fabs(n * (*nb.getV3() - p))));
+                if (h * wmax > COPLANAR_PHASE) continue;
+                group[it->second] = seed;
+                members.push_back(it->second);
+            }
+        }
+        if (members.size() < 2) continue;
+        polygon pg(seed, n);
+        size_t count = 0;
+        for (size_t iTr : members) {
+            triangle &tr = triangles[iTr];
+            node *v[3] = { tr.getV1(), tr.getV2(), tr.getV3() };
+            for (int k = 0; k < 3; k++) {
+                auto it = owner.find(std::make_pair(v[(k + 1) % 3], v[k]));
+                if ((it != owner.end()) && (group[it->second] == (long)seed)) continue;
+                pg.addEdge(*v[k], *v[(k + 1) % 3]);
+                count++;
+            }
+            pg.addFacet(tr);
+        }
+        if (count >= members.size()) continue;
+        for (size_t iTr : members) m_merged[iTr] = 1;
+        merged += members.size();
+        edges += count;
+        m_polygons.push_back(pg);
+    }
+    if (m_polygons.empty()) return;
+    m_polygonOn = true;
+    clogs("копланарные треугольники: " + QString::number(merged) + " объединены в " +
+          QString::number(m_polygons.size()) + " многоугольников (ребер границы " +
+          QString::number(edges) + ")", "", "");
+}
+
+//криволинейные элементы второго порядка на месте изогнутых освещенных
+//треугольников. нормаль вершины - средняя (с весом площади) нормаль смежных
+//треугольников, кроме отделенных кромкой; по нормалям вершин поднимаются
+//узлы на серединах ребер (curvedPatch::midNode). треугольник с малым прогибом
+//ребер и треугольники многоугольников остаются плоскими
+void culcradar::culc_Patches()
+{
+    m_patchOn = false;
+    m_patches.clear();
+    size_t size = triangles.size();
+    m_curvedFacet.assign(size, 0);
+    double wmax = wave + 0.5 * (countY - 1) * fabs(stepW);
+    vector<rVect> normals(size);
+    std::map<node *, vector<size_t>> around;
+    for (size_t iTr = 0; iTr < size; iTr++) {
+        triangle &tr = triangles[iTr];
+        node *v[3] = { tr.getV1(), tr.getV2(), tr.getV3() };
+        normals[iTr] = (*v[1] - *v[0]) ^ (*v[2] - *v[0]);
+        for (int k = 0; k < 3; k++) around[v[k]].push_back(iTr);
+    }
+    size_t points = 0;
+    for (size_t iTr = 0; iTr < size; iTr++) {
+        triangle &tr = triangles[iTr];
+        if (!tr.getVisible()) continue;
+        if (m_polygonOn && m_merged[iTr]) continue;
+        if (m_litOn && (m_lit[iTr] != (LIT_DIRECT | LIT_REFLECTED))) continue;
+        double area = normals[iTr].length();
+        if (area == 0.) continue;
+        rVect n = 1. / area * normals[iTr];
+        node *v[3] = { tr.getV1(), tr.getV2(), tr.getV3() };
+        rVect vn[3];
+        for (int k = 0; k < 3; k++) {
+            for (size_t t : around[v[k]]) {
+                double len = normals[t].length();
+                if ((len > 0.) && (normals[t] * n >= CURVED_CREASE * len)) vn[k] = vn[k] + normals[t];
+            }
+            vn[k] = 1. / vn[k].length() * vn[k];
+        }
+        rVect nodes6[6] = { *v[0], *v[1], *v[2],
+                            curvedPatch::midNode(*v[0], *v[1], vn[0], vn[1]),
+                            curvedPatch::midNode(*v[1], *v[2], vn[1], vn[2]),
+                            curvedPatch::midNode(*v[2], *v[0], vn[2], vn[0]) };
+        double sag = 0.;
+        for (int k = 0; k < 3; k++)
+            sag = std::max(sag, (nodes6[3 + k] - 0.5 * (nodes6[k] + nodes6[(k + 1) % 3])).length());
+        //|Nin - Nout| <= 2
+        if (2 * wmax * sag <= CURVED_PHASE) continue;
+        m_patches.push_back(curvedPatch(iTr, nodes6, wmax));
+        points += m_patches.back().points();
+        m_curvedFacet[iTr] = 1;
     }
+    if (m_patches.empty()) return;
+    m_patchOn = true;
+    clogs("криволинейные элементы: " + QString::number(m_patches.size()) +
+          " треугольников (узлов квадратуры " + QString::number(points) + ")", "", "");
+}
 
+//вклад криволинейных элементов. поляризационный множитель линеен по нормали,
+//поэтому векторные интегралы элементов складываются, а множители берутся для
+//ортов осей один раз на направление
+void culcradar::patch_Sweep(size_t begin, size_t end, rVect Nout_, double w0, size_t n,
+                            vector<cVect> &E, vector<cVect> *E2)
+{
+    if (begin >= end) return;
+    rVect NoutRef_ = Nout_;  NoutRef_.setZ(-Nout_.getZ());
+    const rVect axis[3] = { rVect(1., 0., 0.), rVect(0., 1., 0.), rVect(0., 0., 1.) };
+    rVect pol[2][2][3]; //[поле][Nout, NoutRef][орт]
+    for (int f = 0; f < (E2 ? 2 : 1); f++)
+        for (int c = 0; c < 3; c++) {
+            pol[f][0][c] = curvedPatch::polarization(axis[c], Nout_, f ? Ein2 : Ein);
+            if (ref) pol[f][1][c] = curvedPatch::polarization(axis[c], NoutRef_, f ? Ein2 : Ein);
+        }
+    vector<complex<double>> sOut(3 * n), sRef(ref ? 3 * n : 0), d(3 * n);
+    auto add = [&](rVect a, rVect b, curvedPatch &cp, vector<complex<double>> &sum) {
+        cp.sweep(a, b, w0, stepW, n, d.data());
+        for (size_t j = 0; j < 3 * n; j++) sum[j] += d[j];
+    };
+    for (size_t i = begin; i < end; i++) {
+        if (!RUN_C) return;
+        curvedPatch &cp = m_patches[i];
+        add(Nin, Nout_, cp, sOut);
+        if (!ref) continue;
+        //четыре слагаемых метода изображений
+        add(NinRef, Nout_, cp, sOut);
+        add(Nin, NoutRef_, cp, sRef);
+        add(NinRef, NoutRef_, cp, sRef);
+    }
+    for (int f = 0; f < (E2 ? 2 : 1); f++) {
+        vector<cVect> &F = f ? *E2 : E;
+        for (size_t j = 0; j < n; j++)
+            for (int c = 0; c < 3; c++) {
+                F[j] = F[j] + sOut[3 * j + c] * pol[f][0][c];
+                if (ref) F[j] = F[j] + sRef[3 * j + c] * pol[f][1][c];
+            }
+    }
+}
+
+//поиск зеркальной симметрии освещенных треугольников. плоскость задана в
+//задаче или проверяются плоскости, содержащие Nin: вертикальная и
+//координатные x = const, y = const, проходящие через центр освещенной части.
+//при подстилающей поверхности плоскость должна быть вертикальной
+bool culcradar::culc_Symmetry()
+{
+    m_symmetryOn = false;
+    //пары прошлого диапазона: с ними сложены поляризационные множители
+    vector<std::pair<size_t, size_t>> pairs = m_mirrorPairs;
+    vector<rVect> normals;
+    vector<double> offsets;
+    if (m_symmetryDeclared) {
+        normals.push_back(m_symmetryNormal);
+        offsets.push_back(m_symmetryOffset);
+    }
+    else {
+        rVect centre;
+        double area = 0.;
+        for (triangle &tr : triangles) {
+            if (!tr.getVisible()) continue;
+            double a = ((*tr.getV2() - *tr.getV1()) ^ (*tr.getV3() - *tr.getV1())).length();
+            centre = centre + (a / 3.) * (*tr.getV1() + *tr.getV2() + *tr.getV3());
+            area += a;
+        }
+        if (area == 0.) return false;
+        centre = 1. / area * centre;
+        const rVect planes[3] = { Nin ^ rVect(0., 0., 1.), rVect(1., 0., 0.), rVect(0., 1., 0.) };
+        for (rVect p : planes) {
+            double len = p.length();
+            if (len < 1e-6) continue;
+            rVect m = 1. / len * p;
+            if (fabs(m * Nin) > 1e-9) continue;
+            normals.push_back(m);
+            offsets.push_back(m * centre);
+        }
+    }
+    for (size_t i = 0; i < normals.size(); i++) {
+        if (ref && (fabs(normals[i].getZ()) > 1e-12)) continue;
+        if (!mirror_Pairs(normals[i], offsets[i])) continue;
+        m_symmetryNormal = normals[i];
+        m_symmetryOffset = offsets[i];
+        m_symmetryOn = true;
+        if (m_mirrorPairs != pairs) m_polValid = false;
+        clogs("зеркальная симметрия модели: плоскость (" + QString::number(normals[i].getX(), 'g', 3) + ", " +
+              QString::number(normals[i].getY(), 'g', 3) + ", " + QString::number(normals[i].getZ(), 'g', 3) +
+              ")·r = " + QString::number(offsets[i], 'g', 6) + ", пар треугольников " +
+              QString::number(m_mirrorPairs.size()), "", "");
+        return true;
+    }
+    if (m_symmetryDeclared)
+        clogs("модель не симметрична относительно заданной плоскости, расчет без учета симметрии", "wrn", "");
+    return false;
+}
+
+//пары треугольников, переходящих друг в друга при отражении в плоскости
+//m·r = d. в парах - освещенные треугольники вне многоугольников и
+//криволинейных элементов; у каждого должно быть отражение (или он сам
+//симметричен), иначе симметрии нет. отражение ищется по центру в сетке
+//с шагом 2*tol по соседним ячейкам
+bool culcradar::mirror_Pairs(rVect m, double d)
+{
+    m_mirrorPairs.clear();
+    size_t size = triangles.size();
+    m_mirrorSkip.assign(size, 0);
+    m_symmetryReach = 0.;
+    vector<size_t> facets;
+    double extent = 0.;
+    for (size_t iTr = 0; iTr < size; iTr++) {
+        triangle &tr = triangles[iTr];
+        if (!tr.getVisible()) continue;
+        if ((m_polygonOn && m_merged[iTr]) || (m_patchOn && m_curvedFacet[iTr])) continue;
+        facets.push_back(iTr);
+        extent = std::max(extent, std::max(tr.getV1()->length(),
+                                           std::max(tr.getV2()->length(), tr.getV3()->length())));
+    }
+    if (facets.empty()) return false;
+    double tol = SYMMETRY_TOLERANCE * ((extent > 0.) ? extent : 1.);
+    double cell = 2 * tol;
+    auto mirror = [&](const rVect &r) { return r - (2 * (m * r - d)) * m; };
+    auto centre = [&](size_t iTr) {
+        triangle &tr = triangles[iTr];
+        return 1. / 3. * (*tr.getV1() + *tr.getV2() + *tr.getV3());
+    };
+    typedef std::tuple<long long, long long, long long> cellKey;
+    auto key = [&](rVect r, int dx, int dy, int dz) {
+        return cellKey((long long)floor(r.getX() / cell) + dx, (long long)floor(r.getY() / cell) + dy,
+                       (long long)floor(r.getZ() / cell) + dz);
+    };
+    std::map<cellKey, vector<size_t>> grid;
+    for (size_t iTr : facets) grid[key(centre(iTr), 0, 0, 0)].push_back(iTr);
+
+    vector<long> partner(size, -1);
+    for (size_t iTr : facets) {
+        if (partner[iTr] >= 0) continue;
+        triangle &tr = triangles[iTr];
+        rVect v[3] = { mirror(*tr.getV1()), mirror(*tr.getV2()), mirror(*tr.getV3()) };
+        rVect c = mirror(centre(iTr));
+        long found = -1;
+        for (int dx = -1; (dx <= 1) && (found < 0); dx++)
+            for (int dy = -1; (dy <= 1) && (found < 0); dy++)
+                for (int dz = -1; (dz <= 1) && (found < 0); dz++) {
+                    auto it = grid.find(key(c, dx, dy, dz));
+                    if (it == grid.end()) continue;
+                    for (size_t j : it->second) {
+                        if (partner[j] >= 0) continue;
+                        if (m_litOn && (m_lit[j] != m_lit[iTr])) continue;
+                        triangle &nb = triangles[j];
+                        node *u[3] = { nb.getV1(), nb.getV2(), nb.getV3() };
+                        bool same = true;
+                        for (int k = 0; (k < 3) && same; k++)
+                            same = ((v[k] - *u[0]).length() <= tol) || ((v[k] - *u[1]).length() <= tol) ||
+                                   ((v[k] - *u[2]).length() <= tol);
+                        if (same) {
+                            found = j;
+                            break;
+                        }
+                    }
+                }
+        if (found < 0) return false;
+        partner[iTr] = found;
+        partner[found] = iTr;
+        m_symmetryReach = std::max(m_symmetryReach, std::max(fabs(m * *tr.getV1() - d),
+                                   std::max(fabs(m * *tr.getV2() - d), fabs(m * *tr.getV3() - d))));
+        if ((size_t)found == iTr) continue;
+        m_mirrorPairs.push_back(std::make_pair(iTr, (size_t)found));
+        m_mirrorSkip[found] = 1;
+    }
+    return !m_mirrorPairs.empty();
+}
+
+//BVH текущей модели; строится до запуска потоков, которые его используют
+const facetBvh &culcradar::model_Bvh()
+{
+    if (!m_bvh) {
+        std::shared_ptr<facetBvh> bvh = std::make_shared<facetBvh>();
+        bvh->build(triangles);
+        m_bvh = bvh;
+    }
+    return *m_bvh;
+}
+
+//доля незатененных точек треугольника достаточна для освещенности
+static bool lit_Samples(unsigned shadow)
+{
+    int n = 0;
+    for (int s = 0; s < OCCLUSION_SAMPLES; s++)
+        if (!(shadow & (1u << s))) n++;
+    return 2 * n >= OCCLUSION_SAMPLES;
+}
+
+//освещенность треугольника iTr волной, падающей по In: LIT_DIRECT - прямой
+//волной, LIT_REFLECTED - отраженной от подстилающей поверхности. нормаль
+//треугольника должна быть обращена к источнику; при shadows из точек
+//треугольника (центр и точки медиан) к источнику пускаются лучи по -In,
+//пакет лучей обходит BVH один раз. путь отраженной волны - по -InRef до
+//плоскости z = 0, затем по -In
+char culcradar::facet_Lit(size_t iTr, rVect In, bool shadows)
+{
+    const double bary[OCCLUSION_SAMPLES][3] = { { 1. / 3., 1. / 3., 1. / 3. }, { 2. / 3., 1. / 6., 1. / 6. },
+                                                { 1. / 6., 2. / 3., 1. / 6. }, { 1. / 6., 1. / 6., 2. / 3. } };
+    const unsigned all = (1u << OCCLUSION_SAMPLES) - 1;
+    triangle &tr = triangles[iTr];
+    rVect v[3] = { *tr.getV1(), *tr.getV2(), *tr.getV3() };
+    rVect n = (v[1] - v[0]) ^ (v[2] - v[0]);
+    double len = n.length();
+    if (len == 0.) return 0;
+    n = 1. / len * n;
+    rVect InRef(In.getX(), In.getY(), -In.getZ());
+    char mask = 0;
+    if (n * In < 0.) mask |= LIT_DIRECT;
+    if (ref && (InRef.getZ() > 0.) && (n * InRef < 0.)) mask |= LIT_REFLECTED;
+    if (!shadows || (mask == 0)) return mask;
+
+    rVect o[OCCLUSION_SAMPLES], g[OCCLUSION_SAMPLES];
+    double tmax[OCCLUSION_SAMPLES], tground[OCCLUSION_SAMPLES];
+    double eps = OCCLUSION_OFFSET * std::max((v[1] - v[0]).length(),
+                                             std::max((v[2] - v[1]).length(), (v[0] - v[2]).length()));
+    for (int s = 0; s < OCCLUSION_SAMPLES; s++) {
+        o[s] = bary[s][0] * v[0] + bary[s][1] * v[1] + bary[s][2] * v[2];
+        g[s] = o[s] + eps * n; //начало луча - со стороны волны
+        tmax[s] = std::numeric_limits<double>::max();
+    }
+    rVect up = -1. * In, upRef = -1. * InRef;
+    if ((mask & LIT_DIRECT) && !lit_Samples(m_bvh->occludedPacket(g, OCCLUSION_SAMPLES, up, tmax, iTr)))
+        mask &= ~LIT_DIRECT;
+    if (mask & LIT_REFLECTED) {
+        unsigned shadow = 0;
+        for (int s = 0; s < OCCLUSION_SAMPLES; s++) {
+            tground[s] = g[s].getZ() / InRef.getZ();
+            if (tground[s] <= 0.) shadow |= 1u << s; //точка под плоскостью отражения
+        }
+        shadow |= m_bvh->occludedPacket(g, OCCLUSION_SAMPLES, upRef, tground, iTr);
+        if (shadow != all) {
+            for (int s = 0; s < OCCLUSION_SAMPLES; s++)
+                g[s] = g[s] + tground[s] * upRef;
+            shadow |= m_bvh->occludedPacket(g, OCCLUSION_SAMPLES, up, tmax, triangles.size());
+        }
+        if (!lit_Samples(shadow)) mask &= ~LIT_REFLECTED;
+    }
+    return mask;
+}
+
+//освещенность всех треугольников для направления Nin (освещенность из
+//задачи верна только для ее directVector и не используется); треугольники
+//делятся между потоками. на время расчета неосвещенные треугольники
+//снимаются с освещенности, освещенность из задачи сохраняется в m_clientVisible.
+//освещенность от частоты не зависит: следующие диапазоны задачи берут
+//рассчитанную для того же Nin и той же модели
+bool culcradar::culc_Illumination(bool shadows)
+{
+    size_t size = triangles.size();
+    m_litOn = false;
+    bool cached = m_litValid && (m_litShadows == shadows) && (m_lit.size() == size);
+    if (!cached) {
+        m_litValid = false;
+        m_lit.assign(size, 0);
+        if (shadows) model_Bvh();
+        size_t parts = (size + OCCLUSION_CHUNK - 1) / OCCLUSION_CHUNK;
+        bool ok = culc_Parallel(parts, culc_Threads(), [&](size_t part, int) {
+            for (size_t iTr = part * OCCLUSION_CHUNK; iTr < std::min(size, (part + 1) * OCCLUSION_CHUNK); iTr++)
+                m_lit[iTr] = facet_Lit(iTr, Nin, shadows);
+        }, 0);
+        if (!ok) return false;
+        m_litValid = true;
+        m_litShadows = shadows;
+        m_polValid = false;
+    }
+
+    m_clientVisible.resize(size);
+    size_t lit = 0, partial = 0;
+    for (size_t iTr = 0; iTr < size; iTr++) {
+        m_clientVisible[iTr] = triangles[iTr].getVisible();
+        triangles[iTr].setVisible(m_lit[iTr] != 0);
+        if (m_lit[iTr] == 0) continue;
+        lit++;
+        if (ref && (m_lit[iTr] != (LIT_DIRECT | LIT_REFLECTED)))
+            partial++;
+    }
+    //без подстилающей поверхности освещенность - только признак видимости
+    m_litOn = ref;
+    clogs("освещенность" + QString(shadows ? " с затенением" : "") +
+          (cached ? QString(" (из памяти)") : QString()) + ": освещены " + QString::number(lit) +
+          " из " + QString::number(size) + " треугольников" +
+          (ref ? ", одной волной (прямой или отраженной) " + QString::number(partial) : QString()),
+          "", "");
+    return true;
+}
+
+//многократные отражения методом SBR. лучевые трубки запускаются вдоль Nin с
+//сетки в плоскости, перпендикулярной Nin, перед моделью (шаг - длина волны
+//на верхней частоте, деленная на m_sbrDensity) и трассируются через BVH по
+//всем треугольникам. первое отражение учтено ФО, вклады выходов со второго
+//отражения добавляются к полю на всей сетке. сетка запуска обрабатывается
+//полосами строк: выходы полосы суммируются и освобождаются до трассировки
+//следующей. задача потока при трассировке - строка сетки, при суммировании -
+//направление рассеяния и порция выходов; число порций не зависит от числа
+//потоков, порции складываются по порядку, поэтому результат воспроизводим
+bool culcradar::culc_Sbr()
+{
+    size_t size = triangles.size();
+    if (size == 0) return RUN_C;
+    vector<rVect> normals(size);
+    for (size_t iTr = 0; iTr < size; iTr++) {
+        triangle &tr = triangles[iTr];
+        rVect n = (*tr.getV2() - *tr.getV1()) ^ (*tr.getV3() - *tr.getV1());
+        double len = n.length();
+        if (len > 0.) normals[iTr] = 1. / len * n;
+    }
+
+    //сетка запуска: орты u, v перпендикулярны Nin
+    rVect u = (fabs(Nin.getZ()) < 0.9) ? (Nin ^ rVect(0., 0., 1.)) : (Nin ^ rVect(1., 0., 0.));
+    u = 1. / u.length() * u;
+    rVect v = Nin ^ u;
+    double umin = std::numeric_limits<double>::max(), umax = -umin;
+    double vmin = umin, vmax = -umin, dmin = umin;
+    for (size_t iTr = 0; iTr < size; iTr++) {
+        node *p[3] = { triangles[iTr].getV1(), triangles[iTr].getV2(), triangles[iTr].getV3() };
+        for (int k = 0; k < 3; k++) {
+            rVect r = *p[k];
+            umin = std::min(umin, u * r);  umax = std::max(umax, u * r);
+            vmin = std::min(vmin, v * r);  vmax = std::max(vmax, v * r);
+            dmin = std::min(dmin, Nin * r);
+        }
+    }
+    double wmax = wave + 0.5 * (countY - 1) * fabs(stepW);
+    double delta = 2 * Pi / wmax / m_sbrDensity;
+    double rays = ceil((umax - umin) / delta) * ceil((vmax - vmin) / delta);
+    if (rays > SBR_MAX_RAYS) {
+        delta *= sqrt(rays / SBR_MAX_RAYS);
+        clogs("SBR: число лучей ограничено " + QString::number(SBR_MAX_RAYS, 'g', 3) + ", шаг сетки запуска " +
+              QString::number(delta * wmax / (2 * Pi), 'g', 3) + " длины волны", "wrn", "");
+    }
+    size_t nu = qMax<size_t>(1, (size_t)ceil((umax - umin) / delta));
+    size_t nv = qMax<size_t>(1, (size_t)ceil((vmax - vmin) / delta));
+    rVect base = (dmin - delta) * Nin + (umin + 0.5 * delta) * u + (vmin + 0.5 * delta) * v;
+
+    size_t size1 = vEout[0][0].size();
+    size_t size2 = vEout[0].size();
+    size_t size3 = vEout.size();
+    size_t dirs = size1 * size3;
+    double w0 = wave + 0.5 * (countY - 1) * stepW;
+    cFields fields = culc_Fields();
+    int threads = culc_Threads();
+    sbrTracer tracer(model_Bvh(), normals);
+    vector<int> deepest(threads, 0);
+    rVect E2 = dual ? Ein2 : rVect();
+    size_t band = qMax<size_t>(1, SBR_BAND_RAYS / nv);
+    size_t total = 0;
+    for (size_t i0 = 0; i0 < nu; i0 += band) {
+        //трассировка полосы: выходы по строкам сетки запуска
+        size_t i1 = std::min(nu, i0 + band);
+        vector<vector<sbrExit>> rows(i1 - i0);
+        if (!culc_Parallel(i1 - i0, threads, [&](size_t i, int thread) {
+                for (size_t j = 0; j < nv; j++) {
+                    rVect o = base + ((i0 + i) * delta) * u + (j * delta) * v;
+                    int bounces = tracer.trace(o, Nin, delta * u, delta * v, Ein, E2, m_sbrBounces, rows[i]);
+                    deepest[thread] = std::max(deepest[thread], bounces);
+                }
+            }, 0)) return false;
+        vector<sbrExit> exits;
+        size_t count = 0;
+        for (size_t i = 0; i < rows.size(); i++) count += rows[i].size();
+        exits.reserve(count);
+        for (size_t i = 0; i < rows.size(); i++) {
+            exits.insert(exits.end(), rows[i].begin(), rows[i].end());
+            vector<sbrExit>().swap(rows[i]);
+        }
+        total += exits.size();
+        if (exits.empty()) continue;
+
+        //вклады выходов полосы: m = iy + size2 * (ix + size1 * iz), поле - по порциям
+        size_t chunks = qMax<size_t>(1, std::min((exits.size() + SBR_CHUNK - 1) / SBR_CHUNK, SBR_TASKS / dirs));
+        size_t span = (exits.size() + chunks - 1) / chunks;
+        vector<vector<cVect>> acc(chunks > 1 ? chunks * fields.size() : 0, vector<cVect>(dirs * size2));
+        bool ok = culc_Parallel(dirs * chunks, threads, [&](size_t k, int) {
+            size_t dir = k / chunks, chunk = k % chunks;
+            size_t ix = dir % size1, iz = dir / size1;
+            rVect Nout_, NoutRef_;
+            culc_Direction(ix, iz, Nout_, NoutRef_);
+            vector<complex<double>> d(size2);
+            vector<cVect> E[2];
+            for (size_t f = 0; f < fields.size(); f++) E[f].assign(size2, cVect());
+            for (size_t i = chunk * span; i < std::min(exits.size(), (chunk + 1) * span); i++) {
+                const sbrExit &e = exits[i];
+                sbrTracer::sweep(e, Nout_, w0, stepW, size2, d.data());
+                for (size_t f = 0; f < fields.size(); f++) {
+                    rVect pol = sbrTracer::polarization(e, Nout_, f ? e.E2 : e.E);
+                    for (size_t iy = 0; iy < size2; iy++) E[f][iy] = E[f][iy] + d[iy] * pol;
+                }
+            }
+            for (size_t f = 0; f < fields.size(); f++) {
+                if (chunks > 1) {
+                    vector<cVect> &A = acc[chunk * fields.size() + f];
+                    for (size_t iy = 0; iy < size2; iy++) A[iy + size2 * dir] = E[f][iy];
+                }
+                else
+                    for (size_t iy = 0; iy < size2; iy++)
+                        (*fields[f])[iz][iy][ix] = (*fields[f])[iz][iy][ix] + E[f][iy];
+            }
+        }, 0);
+        if (!ok) return false;
+        for (size_t a = 0; a < acc.size(); a++) {
+            cField &F = *fields[a % fields.size()];
+            for (size_t m = 0; m < dirs * size2; m++) {
+                size_t iy = m % size2, ix = (m / size2) % size1, iz = m / (size2 * size1);
+                F[iz][iy][ix] = F[iz][iy][ix] + acc[a][m];
+            }
+        }
+    }
+    clogs("SBR: лучей " + QString::number(nu * nv) + ", выходов многократных отражений " +
+          QString::number(total) + ", отражений не больше " +
+          QString::number(*std::max_element(deepest.begin(), deepest.end())), "", "");
+    return RUN_C;
+}
+
+//вклад треугольника iTr с подстилающей поверхностью: четыре слагаемых метода
+//изображений, если треугольник освещен обеими волнами, иначе два слагаемых
+//освещающей волны
+void culcradar::facet_RefSweep(size_t iTr, rVect Nout_, double w0, size_t n,
+                               complex<double> *dOut, complex<double> *dRef, complex<double> *tmp)
+{
+    char lit = m_litOn ? m_lit[iTr] : (LIT_DIRECT | LIT_REFLECTED);
+    facet_RefSweep(iTr, lit, Nin, Nout_, w0, stepW, n, dOut, dRef, tmp);
+}
+
+void culcradar::facet_RefSweep(size_t iTr, char lit, rVect In, rVect Nout_, double w0, double dW, size_t n,
+                               complex<double> *dOut, complex<double> *dRef, complex<double> *tmp)
+{
+    triangle &tr = triangles[iTr];
+    if (lit == (LIT_DIRECT | LIT_REFLECTED)) {
+        m_kernel->refSweep(tr, In, Nout_, w0, dW, n, dOut, dRef, tmp);
+        return;
+    }
+    rVect In_ = In;
+    if (!(lit & LIT_DIRECT)) In_.setZ(-In.getZ());
+    rVect NoutRef_ = Nout_;  NoutRef_.setZ(-Nout_.getZ());
+    m_kernel->sweep(tr, In_, Nout_, w0, dW, n, dOut);
+    m_kernel->sweep(tr, In_, NoutRef_, w0, dW, n, dRef);
+}
+
+//число узлов Чебышева, при котором погрешность интерполяции функции с
+//фазой, меняющейся на отрезке не более чем на +-B, не превышает tol:
+//4*(B/2)^p/p! <= tol. больше CLUSTER_POINTS - интерполяция невыгодна
+static int cheb_Points(double B, double tol)
+{
+    if (B <= 0.) return 1;
+    double t = 4.;
+    for (int p = 1; p <= CLUSTER_POINTS; p++) {
+        t *= 0.5 * B / p;
+        if ((p > 1) && (t <= tol)) return p;
+    }
+    return CLUSTER_POINTS + 1;
+}
+
+//агрегация кластеров треугольников. вклад кластера в точку сетки
+//E = exp(i*w*q·c) * G(w, углы), q = Nin - Nout, c - центр кластера; фаза G
+//меняется не быстрее w*|q|*радиус, поэтому G задается значениями в узлах
+//Чебышева по частоте и двум углам сетки. кластеры выбираются по октодереву
+//снизу вверх: узел агрегируется, если это дешевле прямого счета его
+//треугольников и лучшего выбора в потомках. значения в узлах считаются
+//один раз на задачу, в плитке вклад кластера стоит p_w + 2 операций на
+//частоту (см. cluster_Tile) вместо вкладов всех его треугольников.
+//возвращает false при остановке расчета
+bool culcradar::culc_Clusters()
+{
+    m_clusterOn = false;
+    m_clusters.clear();
+    m_clusterFacets.clear();
+    m_clusterList.clear();
+    m_clustered.assign(triangles.size(), 0);
+    vector<rVect> centres(triangles.size());
+    for (size_t iTr = 0; iTr < triangles.size(); iTr++) {
+        triangle &tr = triangles[iTr];
+        if (!tr.getVisible()) continue;
+        if (m_polygonOn && m_merged[iTr]) continue;
+        if (m_patchOn && m_curvedFacet[iTr]) continue;
+        centres[iTr] = 1. / 3. * (*tr.getV1() + *tr.getV2() + *tr.getV3());
+        m_clusterFacets.push_back(iTr);
+    }
+    if (m_clusterFacets.empty()) return true;
+    facetCluster root;
+    root.begin = 0;
+    root.end = m_clusterFacets.size();
+    m_clusters.push_back(root);
+    split_Cluster(centres, 0, 0);
+    size_t num = vEout.size() * vEout[0].size() * vEout[0][0].size();
+    select_Clusters(0, num);
+    if (m_clusterList.empty()) {
+        clogs("агрегация кластеров невыгодна, расчет прямым суммированием", "", "");
+        return true;
+    }
+
+    //узлы интерполяции
+    size_t total = 0, facets = 0;
+    for (int c : m_clusterList) {
+        facetCluster &cl = m_clusters[c];
+        cl.sample = total;
+        total += (size_t)cl.pw * cl.px * cl.pz;
+        facets += cl.end - cl.begin;
+        for (size_t i = cl.begin; i < cl.end; i++)
+            m_clustered[m_clusterFacets[i]] = 1;
+    }
+    double Hw = 0.5 * (countY - 1) * stepW;
+    double Hx = 0.5 * (countX - 1) * dAngleX;
+    double Hz = 0.5 * (countZ - 1) * dAngleZ;
+    for (int f = 0; f < 2; f++)
+        m_clusterSamples[f].assign((f == 0) || dual ? total : 0, cVect());
+    bool ok = culc_Parallel(m_clusterList.size(), culc_Threads(), [&](size_t i, int) {
+        const facetCluster &cl = m_clusters[m_clusterList[i]];
+        cVect *S = m_clusterSamples[0].data() + cl.sample;
+        cVect *S2 = dual ? m_clusterSamples[1].data() + cl.sample : nullptr;
+        for (int kz = 0; kz < cl.pz; kz++)
+            for (int kx = 0; kx < cl.px; kx++) {
+                rVect Nout_ = culc_Direction(Hx * cheb_Node(cl.px, kx), Hz * cheb_Node(cl.pz, kz));
+                rVect q = Nin - Nout_;
+                for (int kw = 0; kw < cl.pw; kw++) {
+                    double w = wave + Hw * cheb_Node(cl.pw, kw);
+                    cVect G, G2;
+                    for (size_t k = cl.begin; k < cl.end; k++) {
+                        triangle &tr = triangles[m_clusterFacets[k]];
+                        complex<double> d = tr.Difraction(Nin, Nout_, w);
+                        G = G + d * tr.CulcPolarization(Nin, Nout_, Ein);
+                        if (S2) G2 = G2 + d * tr.CulcPolarization(Nin, Nout_, Ein2);
+                    }
+                    complex<double> shift = exp(-OneI * w * (q * cl.centre));
+                    size_t s = (kz * cl.px + kx) * cl.pw + kw;
+                    S[s] = shift * G;
+                    if (S2) S2[s] = shift * G2;
+                }
+            }
+    }, 0);
+    if (!ok) return false;
+    m_clusterOn = true;
+    clogs("кластеров " + QString::number(m_clusterList.size()) + ", в них " +
+          QString::number(facets) + " из " + QString::number(m_clusterFacets.size()) +
+          " треугольников, узлов интерполяции " + QString::number(total), "", "");
+    return true;
+}
+
+//деление узла октодерева по октантам относительно середины центров треугольников;
+//центр кластера - середина, радиус - по вершинам треугольников
+void culcradar::split_Cluster(const vector<rVect> &centres, int node, int depth)
+{
+    size_t begin = m_clusters[node].begin, end = m_clusters[node].end;
+    rVect lo = centres[m_clusterFacets[begin]], hi = lo;
+    for (size_t i = begin; i < end; i++) {
+        rVect r = centres[m_clusterFacets[i]];
+        lo.setPoint(std::min(lo.getX(), r.getX()), std::min(lo.getY(), r.getY()), std::min(lo.getZ(), r.getZ()));
+        hi.setPoint(std::max(hi.getX(), r.getX()), std::max(hi.getY(), r.getY()), std::max(hi.getZ(), r.getZ()));
+    }
+    rVect c = 0.5 * (lo + hi);
+    double radius = 0.;
+    for (size_t i = begin; i < end; i++) {
+        triangle &tr = triangles[m_clusterFacets[i]];
+        radius = std::max(radius, (*tr.getV1() - c).length());
+        radius = std::max(radius, (*tr.getV2() - c).length());
+        radius = std::max(radius, (*tr.getV3() - c).length());
+    }
+    facetCluster &cl = m_clusters[node];
+    cl.centre = c;
+    cl.radius = radius;
+    cl.child = 0;
+    cl.children = 0;
+    if ((end - begin <= CLUSTER_LEAF) || (depth >= CLUSTER_DEPTH)) return;
+
+    //треугольники упорядочиваются по октантам: x, затем y, затем z
+    size_t *f = m_clusterFacets.data();
+    vector<size_t> bounds(1, begin);
+    auto part = [&](size_t b, size_t e, int axis) {
+        return std::partition(f + b, f + e, [&](size_t iTr) {
+            rVect r = centres[iTr];
+            double v = (axis == 0) ? r.getX() : ((axis == 1) ? r.getY() : r.getZ());
+            double m = (axis == 0) ? c.getX() : ((axis == 1) ? c.getY() : c.getZ());
+            return v < m;
+        }) - f;
+    };
+    size_t mx = part(begin, end, 0);
+    size_t xs[3] = { begin, mx, end };
+    for (int i = 0; i < 2; i++) {
+        size_t my = part(xs[i], xs[i + 1], 1);
+        size_t ys[3] = { xs[i], my, xs[i + 1] };
+        for (int j = 0; j < 2; j++) {
+            bounds.push_back(part(ys[j], ys[j + 1], 2));
+            bounds.push_back(ys[j + 1]);
+        }
+    }
+    //все центры совпадают - делить нечего
+    int child = m_clusters.size();
+    for (size_t k = 0; k + 1 < bounds.size(); k++) {
+        if ((bounds[k] == bounds[k + 1]) || (bounds[k + 1] - bounds[k] == end - begin)) continue;
+        facetCluster sub;
+        sub.begin = bounds[k];
+        sub.end = bounds[k + 1];
+        m_clusters.push_back(sub);
+    }
+    int children = m_clusters.size() - child;
+    m_clusters[node].child = child;
+    m_clusters[node].children = children;
+    for (int k = 0; k < children; k++)
+        split_Cluster(centres, child + k, depth + 1);
+}
+
+//выбор агрегируемых узлов поддерева; возвращает стоимость его расчета в
+//вкладах треугольника (вклад с поляризационным множителем - две операции,
+//значение в узле интерполяции - около десяти на треугольник)
+double culcradar::select_Clusters(int node, size_t samples)
+{
+    facetCluster &cl = m_clusters[node];
+    double N = cl.end - cl.begin;
+    double tol = m_engineTolerance / 3.;
+    double Hw = 0.5 * (countY - 1) * fabs(stepW);
+    double Hx = 0.5 * (countX - 1) * fabs(dAngleX);
+    double Hz = 0.5 * (countZ - 1) * fabs(dAngleZ);
+    double wmax = wave + Hw;
+    cl.pw = cheb_Points(2. * cl.radius * Hw, tol);
+    cl.px = cheb_Points((wmax * cl.radius + 1.) * Hx, tol);
+    cl.pz = cheb_Points((wmax * cl.radius + 1.) * Hz, tol);
+
+    double direct = 2. * N * samples;
+    double children = direct;
+    size_t mark = m_clusterList.size();
+    if (cl.children > 0) {
+        int child = cl.child, count = cl.children;
+        children = 0.;
+        for (int k = 0; k < count; k++)
+            children += select_Clusters(child + k, samples);
+    }
+    facetCluster &c = m_clusters[node]; //ссылка cl могла устареть
+    if ((c.pw > CLUSTER_POINTS) || (c.px > CLUSTER_POINTS) || (c.pz > CLUSTER_POINTS))
+        return children;
+    double points = (double)c.pw * c.px * c.pz;
+    double n = std::min(TILE_SAMPLES, (size_t)countY);
+    double tiles = samples / n;
+    double cost = CLUSTER_GAIN * (tiles * (points + n * (c.pw + 2)) + 10. * points * N);
+    if (cost >= children) return children;
+    m_clusterList.resize(mark);
+    m_clusterList.push_back(node);
+    return cost;
+}
+
+//вклад агрегированных кластеров в плитку: n частот направления (ix, iz),
+//начиная с iy0. значения в узлах сворачиваются по углам, затем по частоте;
+//фаза центра кластера по частотам считается рекуррентно
+void culcradar::cluster_Tile(size_t ix, size_t iz, size_t iy0, size_t n,
+                             vector<cVect> &E, vector<cVect> *E2)
+{
+    double Hw = 0.5 * (countY - 1) * stepW;
+    double Hx = 0.5 * (countX - 1) * dAngleX;
+    double Hz = 0.5 * (countZ - 1) * dAngleZ;
+    double ax = (1. * ix - 0.5 * (countX - 1)) * dAngleX;
+    double az = (1. * iz - 0.5 * (countZ - 1)) * dAngleZ;
+    double w0 = wave - (1. * iy0 - 0.5 * (countY - 1)) * stepW;
+    rVect q = Nin - culc_Direction(ax, az);
+    //веса интерполяции по числу узлов: по углам - одна точка, по частоте - n
+    vector<vector<double>> bx(CLUSTER_POINTS + 1), bz(CLUSTER_POINTS + 1), bw(CLUSTER_POINTS + 1);
+    vector<cVect> A(CLUSTER_POINTS), A2(E2 ? CLUSTER_POINTS : 0);
+    for (int c : m_clusterList) {
+        if (!RUN_C) return;
+        const facetCluster &cl = m_clusters[c];
+        if (bx[cl.px].empty()) {
+            bx[cl.px].resize(cl.px);
+            cheb_Basis(cl.px, (Hx != 0.) ? ax / Hx : 0., bx[cl.px].data());
+        }
+        if (bz[cl.pz].empty()) {
+            bz[cl.pz].resize(cl.pz);
+            cheb_Basis(cl.pz, (Hz != 0.) ? az / Hz : 0., bz[cl.pz].data());
+        }
+        if (bw[cl.pw].empty()) {
+            bw[cl.pw].resize(n * cl.pw);
+            for (size_t j = 0; j < n; j++)
+                cheb_Basis(cl.pw, (Hw != 0.) ? (w0 - j * stepW - wave) / Hw : 0., bw[cl.pw].data() + j * cl.pw);
+        }
+        const double *lx = bx[cl.px].data(), *lz = bz[cl.pz].data(), *lw = bw[cl.pw].data();
+        const cVect *S = m_clusterSamples[0].data() + cl.sample;
+        const cVect *S2 = E2 ? m_clusterSamples[1].data() + cl.sample : nullptr;
+        for (int kw = 0; kw < cl.pw; kw++) {
+            A[kw] = cVect();
+            if (E2) A2[kw] = cVect();
+        }
+        for (int kz = 0; kz < cl.pz; kz++)
+            for (int kx = 0; kx < cl.px; kx++) {
+                complex<double> l = lz[kz] * lx[kx];
+                size_t s = (kz * cl.px + kx) * cl.pw;
+                for (int kw = 0; kw < cl.pw; kw++) {
+                    A[kw] = A[kw] + l * S[s + kw];
+                    if (E2) A2[kw] = A2[kw] + l * S2[s + kw];
+                }
+            }
+        double phase = q * cl.centre;
+        complex<double> e = exp(OneI * w0 * phase), step = exp(-OneI * stepW * phase);
+        for (size_t j = 0; j < n; j++) {
+            cVect G, G2;
+            for (int kw = 0; kw < cl.pw; kw++) {
+                complex<double> l = lw[j * cl.pw + kw];
+                G = G + l * A[kw];
+                if (E2) G2 = G2 + l * A2[kw];
+            }
+            E[j] = E[j] + e * G;
+            if (E2) (*E2)[j] = (*E2)[j] + e * G2;
+            e *= step;
+        }
+    }
+}
+
+//стоимость расчета samples точек: число вкладов освещенных треугольников в поле
+double culcradar::culc_Cost(size_t samples)
+{
+    size_t visible = 0;
+    for (size_t iTr = 0; iTr < triangles.size(); iTr++)
+        if (triangles[iTr].getVisible()) visible++;
+    return (double)samples * visible;
+}
+
+QString culcradar::kernel_Name()
+{
+    return m_kernel->name;
+}
+
+//режим ядра: время одного вклада с подстилающей поверхностью и без нее различно
+QString culcradar::culc_Mode()
+{
+    if (!m_rcsAngles.empty())
+        return ref ? "rcs_ref" : "rcs";
+    if (!m_isarAngles.empty())
+        return ref ? "isar_ref" : "isar";
+    QString mode = ref ? "po_ref" : "po";
+    if (dual) mode += "_dual";
+    if (m_nufft && !ref) return mode + "_nufft";
+    if (m_cluster && !ref) return mode + "_cluster";
+    if (m_kernel->reduced) mode += "_f32";
+    return mode;
+}
+
+//запись поля в поток: шесть чисел double на точку (Re, Im по X, Y, Z)
+void culcradar::write_Field(QDataStream &stream, cField &field)
+{
+    for (size_t iz = 0; iz < field.size(); iz++)
+        for (size_t iy = 0; iy < field[0].size(); iy++)
+            for (size_t ix = 0; ix < field[0][0].size(); ix++) {
+                cVect &E = field[iz][iy][ix];
+                stream << E.getX().real() << E.getX().imag()
+                       << E.getY().real() << E.getY().imag()
+                       << E.getZ().real() << E.getZ().imag();
+            }
+}
+
+//чтение поля из потока; размерности field задаются заранее
+bool culcradar::read_Field(QDataStream &stream, cField &field)
+{
+    for (size_t iz = 0; iz < field.size(); iz++)
+        for (size_t iy = 0; iy < field[0].size(); iy++)
+            for (size_t ix = 0; ix < field[0][0].size(); ix++) {
+                double re[3], im[3];
+                stream >> re[0] >> im[0] >> re[1] >> im[1] >> re[2] >> im[2];
+                field[iz][iy][ix].setPoint(complex<double>(re[0], im[0]),
+                                           complex<double>(re[1], im[1]),
+                                           complex<double>(re[2], im[2]));
+            }
+    return stream.status() == QDataStream::Ok;
+}
+
+//запись контрольной точки: размерности, параметры задачи, курсор цикла и поле
+bool culcradar::save_Checkpoint(size_t cursor)
+{
+    if (m_checkpoint.isEmpty()) return false;
+    QSaveFile file(m_checkpoint);
+    if (!file.open(QIODevice::WriteOnly)) {
+        clogs("файл " + m_checkpoint + " не может быть открыт","wrn","");
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << quint32(CHECKPOINT_MAGIC) << quint32(CHECKPOINT_VERSION);
+    stream << quint32(vEout[0][0].size()) << quint32(vEout[0].size()) << quint32(vEout.size());
+    stream << quint32(triangles.size()) << ref << wave << stepW
+           << Nin.getX() << Nin.getY() << Nin.getZ();
+    stream << quint64(cursor);
+    cFields fields = culc_Fields();
+    stream << quint32(fields.size());
+    for (cField *field : fields)
+        write_Field(stream, *field);
+    if (!file.commit()) {
+        clogs("контрольная точка " + m_checkpoint + " не записана","wrn","");
+        return false;
+    }
+    return true;
+}
+
+//чтение контрольной точки; поле принимается только для той же задачи
+bool culcradar::load_Checkpoint(size_t &cursor)
+{
+    if (m_checkpoint.isEmpty()) return false;
+    QFile file(m_checkpoint);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic, version, sX, sY, sZ, nTr;
+    bool ref_;
+    double wave_, stepW_, x, y, z;
+    quint64 cur;
+    quint32 nFields;
+    cFields fields = culc_Fields();
+    stream >> magic >> version >> sX >> sY >> sZ >> nTr >> ref_ >> wave_ >> stepW_ >> x >> y >> z >> cur >> nFields;
+    if ((stream.status() != QDataStream::Ok) || (magic != CHECKPOINT_MAGIC) ||
+        (version != CHECKPOINT_VERSION) ||
+        (sX != vEout[0][0].size()) || (sY != vEout[0].size()) || (sZ != vEout.size()) ||
+        (nTr != triangles.size()) || (ref_ != ref) || (wave_ != wave) || (stepW_ != stepW) ||
+        (rVect(x, y, z) != Nin) || (cur > (quint64)sX * sY * sZ) || (nFields != fields.size())) {
+        clogs("контрольная точка " + m_checkpoint + " не соответствует задаче","wrn","");
+        return false;
+    }
+    vector<cField> read;
+    for (cField *field : fields) {
+        read.push_back(*field);
+        if (!read_Field(stream, read.back())) {
+            clogs("контрольная точка " + m_checkpoint + " повреждена","wrn","");
+            return false;
+        }
+    }
+    for (size_t i = 0; i < fields.size(); i++)
+        *fields[i] = read[i];
+    cursor = cur;
+    return true;
+}
+
+//моностатическая ЭПР по азимуту: sigma = 4*Pi*|E*Er|^2, где Er - поляризация приема.
+//на каждом угле поле одно, поэтому fft не нужен; освещенность треугольников
+//считается для каждого угла. углы считаются параллельно квантами
+int culcradar::culc_Rcs(vector<double> &sigma)
+{
+    size_t size = m_rcsAngles.size();
+    sigma.assign(size, 0.);
+    m_total = size; m_start = 0; m_done = 0;
+    progress = stage_Progress(0);
+    count = true;
+    signal_send_progress_bar_culcradar();
+
+    rVect In0 = Nin;
+    int inc_polariz = RWave.getIncPolariz();
+    int ref_polariz = RWave.getRefPolariz();
+    auto task = [&](size_t a, int) {
+        rVect In = rotate_Z(In0, m_rcsAngles[a]);
+        rVect InRef(In.getX(), In.getY(), -In.getZ());
+        rVect Out = -1. * In;
+        rVect OutRef = -1. * InRef;
+        radar_wave pol(RWave);
+        rVect Einc, Erec;
+        pol.setPolariz(inc_polariz, inc_polariz, In, Einc);
+        pol.setPolariz(ref_polariz, ref_polariz, In, Erec);
+        cVect E;
+        for (size_t iTr = 0; (iTr < triangles.size()) && RUN_C; iTr++) {
+            char lit = facet_Lit(iTr, In, m_occlusion);
+            if (lit == 0) continue;
+            //одна частота - вызов выбранного ядра с n = 1
+            complex<double> dOut, dRef, tmp;
+            if (ref) {
+                facet_RefSweep(iTr, lit, In, Out, wave, stepW, 1, &dOut, &dRef, &tmp);
+                E = E + dRef * triangles[iTr].CulcPolarization(In, OutRef, Einc);
+            }
+            else
+                m_kernel->sweep(triangles[iTr], In, Out, wave, stepW, 1, &dOut);
+            E = E + dOut * triangles[iTr].CulcPolarization(In, Out, Einc);
+        }
+        sigma[a] = 4. * Pi * std::norm(dot(E, Erec));
+    };
+    if (!culc_Sliced(size, task, 1, 0)) return -1;
+
+    progress = stage_Progress(100);
+    signal_send_progress_bar_culcradar();
+    return 0;
+}
+
+//независимые задачи внутри одного кванта - постоянным пулом потоков ядра
+//(workerPool). на паузе задачи не выдаются до продолжения или остановки
+bool culcradar::culc_Parallel(size_t size, int threads, const std::function<void(size_t, int)> &task, size_t weight)
+{
+    culc_Until(size, threads, [&](size_t i, int thread) {
+        while (PAUSE_C && RUN_C)
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (RUN_C) task(i, thread);
+    }, [&]() { return !RUN_C; }, weight);
+    return RUN_C;
+}
+
+size_t culcradar::culc_Until(size_t size, int threads, const std::function<void(size_t, int)> &task,
+                             const std::function<bool()> &stop, size_t weight)
+{
+    size_t base = m_done;
+    size_t done = m_pool.run(size, threads, task, stop, [&](size_t done) {
+        m_done = base + done * weight;
+        int p = stage_Progress(100. * m_done / m_total);
+        if ((p != progress) && (p < 100)) {
+            progress = p;
+            signal_send_progress_bar_culcradar();
+        }
+    }, 200);
+    m_done = base + done * weight;
+    return done;
+}
+
+//в квант пулу передаются все оставшиеся задачи; выдача задач заканчивается
+//по времени кванта или на паузе, на паузе слот отдается другим задачам до
+//продолжения. BVH для затенения строится в первом кванте
+bool culcradar::culc_Sliced(size_t size, const std::function<void(size_t, int)> &task, size_t weight, size_t ahead)
+{
+    for (size_t a0 = 0; a0 < size; ) {
+        if (!begin_Slice(culc_Cost((size - a0) * weight + ahead))) return false;
+        if (m_occlusion) model_Bvh();
+        auto sliced = std::chrono::steady_clock::now();
+        std::chrono::milliseconds slice(SLICE_MS);
+        a0 += culc_Until(size - a0, culc_Threads(), [&](size_t i, int thread) { task(a0 + i, thread); },
+                         [&]() { return !RUN_C || PAUSE_C ||
+                                        (std::chrono::steady_clock::now() - sliced >= slice); }, weight);
+        end_Slice();
+        if (!RUN_C) return false;
+        while (PAUSE_C && RUN_C)
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (!RUN_C) return false;
+    }
+    return RUN_C;
+}
+
+//число точек задачи ISAR: спектры ракурсов плюс обратное проецирование,
+//приведенное к стоимости точки (интерполяция профиля ракурса на пиксель
+//против вклада треугольника)
+size_t culcradar::isar_Samples()
+{
+    size_t spectra = m_isarAngles.size() * count_Axis(Lmax, RWave.getStepY());
+    size_t visible = qMax<size_t>(1, (size_t)culc_Cost(1));
+    size_t row = (m_isarAngles.size() * m_isarSize + visible - 1) / visible;
+    return spectra + row * m_isarSize;
+}
+
+//ISAR: для каждого ракурса считается моностатический спектр по частотам
+//диапазона (та же сетка, что и для оси дальности радиопортрета), затем
+//изображение в плоскости XY, проходящей через центр модели, строится
+//обратным проецированием: I(r) = sum S(a,w) exp(-i*w*2*In(a)*r).
+//сумма по частотам - профиль дальности ракурса g(u) = sum S(a,w) exp(-i*w*u):
+//он считается один раз fft спектра с дополнением нулями и без несущей
+//центральной частоты wc (огибающая h(u) = g(u) exp(i*wc*u) медленно меняется
+//по u), для пикселя берется линейной интерполяцией. несущая по строке
+//изображения считается рекуррентно
+int culcradar::culc_Isar(vector<vector<double>> &image, double &x0, double &y0, double &pixel)
+{
+    size_t nA = m_isarAngles.size();
+    int nF = count_Axis(Lmax, RWave.getStepY());
+    double dW = 6. / (1. * nF * RWave.getStepY());
+    double w0 = wave + 0.5 * (nF - 1) * dW;
+    int size = m_isarSize;
+    pixel = m_isarPixel;
+
+    rVect rmin = (rVect)get_Node(0), rmax = rmin;
+    for (size_t i = 1; i < nodes.size(); i++) {
+        rVect r = (rVect)get_Node(i);
+        rmin.setPoint(std::min(rmin.getX(), r.getX()), std::min(rmin.getY(), r.getY()),
+                      std::min(rmin.getZ(), r.getZ()));
+        rmax.setPoint(std::max(rmax.getX(), r.getX()), std::max(rmax.getY(), r.getY()),
+                      std::max(rmax.getZ(), r.getZ()));
+    }
+    rVect center = 0.5 * (rmin + rmax);
+    x0 = center.getX() - 0.5 * (size - 1) * pixel;
+    y0 = center.getY() - 0.5 * (size - 1) * pixel;
+
+    m_total = isar_Samples(); m_start = 0; m_done = 0;
+    progress = stage_Progress(0);
+    count = true;
+    signal_send_progress_bar_culcradar();
+
+    //спектры ракурсов: поляризационный множитель треугольника от частоты не зависит,
+    //освещенность треугольников считается для каждого ракурса
+    rVect In0 = Nin;
+    int inc_polariz = RWave.getIncPolariz();
+    int ref_polariz = RWave.getRefPolariz();
+    vector<rVect> dirs(nA);
+    //профиль ракурса: отсчеты h(m*du), m = -N/2..N/2; g периодична по u с
+    //периодом N*du = 2*Pi/dW, огибающая при сдвиге на период умножается на exp(-2*Pi*i*c)
+    int N = pad2(nF * ISAR_PAD);
+    double du = 2. * Pi / (N * dW);
+    double c = 0.5 * (nF - 1);
+    double wc = w0 - c * dW;
+    vector<vector<complex<double>>> H(nA);
+    size_t row = (m_total - nA * nF) / qMax(1, size);
+    bool ok = culc_Sliced(nA, [&](size_t a, int) {
+        rVect In = rotate_Z(In0, m_isarAngles[a]);
+        rVect InRef(In.getX(), In.getY(), -In.getZ());
+        rVect Out = -1. * In;
+        rVect OutRef = -1. * InRef;
+        radar_wave pol(RWave);
+        rVect Einc, Erec;
+        pol.setPolariz(inc_polariz, inc_polariz, In, Einc);
+        pol.setPolariz(ref_polariz, ref_polariz, In, Erec);
+        dirs[a] = In;
+        vector<complex<double>> s(N), d(nF), dRef(nF), t(nF);
+        for (size_t iTr = 0; (iTr < triangles.size()) && RUN_C; iTr++) {
+            char lit = facet_Lit(iTr, In, m_occlusion);
+            if (lit == 0) continue;
+            triangle &tr = triangles[iTr];
+            double p = tr.CulcPolarization(In, Out, Einc) * Erec;
+            if (!ref) {
+                m_kernel->sweep(tr, In, Out, w0, dW, nF, d.data());
+                for (int j = 0; j < nF; j++) s[j] += d[j] * p;
+                continue;
+            }
+            double pRef = tr.CulcPolarization(In, OutRef, Einc) * Erec;
+            facet_RefSweep(iTr, lit, In, Out, w0, dW, nF, d.data(), dRef.data(), t.data());
+            for (int j = 0; j < nF; j++) s[j] += d[j] * p + dRef[j] * pRef;
+        }
+        //g(m*du) = sum_j S_j exp(i*2*Pi*j*m/N) exp(-i*w0*m*du); fft нормирован на 1/sqrt(N)
+        s = fft(s, 1);
+        vector<complex<double>> &h = H[a];
+        h.resize(N + 1);
+        for (int m = -N / 2; m <= N / 2; m++)
+            h[m + N / 2] = sqrt(1. * N) * s[(m + N) % N] * exp(-OneI * (c * dW * m * du));
+    }, nF, row * size);
+
+    //обратное проецирование по строкам изображения
+    image.assign(size, vector<double>(size, 0.));
+    double norm = 1. / (1. * nA * nF);
+    if (ok) ok = culc_Sliced(size, [&](size_t iy, int) {
+        vector<complex<double>> I(size);
+        rVect r0(x0, y0 + iy * pixel, center.getZ());
+        for (size_t a = 0; a < nA; a++) {
+            const complex<double> *h = H[a].data() + N / 2;
+            double u0 = 2. * (dirs[a] * r0);
+            double uStep = 2. * pixel * dirs[a].getX();
+            complex<double> e = exp(-OneI * (wc * u0));
+            complex<double> step = exp(-OneI * (wc * uStep));
+            for (int ix = 0; ix < size; ix++) {
+                double t = (u0 + ix * uStep) / du;
+                double k = floor(t / N + 0.5);
+                t -= k * N;
+                int i0 = std::max(-N / 2, std::min(N / 2 - 1, (int)floor(t)));
+                double f = t - i0;
+                complex<double> v = (1. - f) * h[i0] + f * h[i0 + 1];
+                if (k != 0.) v *= exp(-OneI * (2. * Pi * c * k));
+                I[ix] += v * e;
+                e *= step;
+            }
+        }
+        for (int ix = 0; ix < size; ix++) image[iy][ix] = std::abs(I[ix]) * norm;
+    }, row, 0);
+    if (!ok) return -1;
+
+    progress = stage_Progress(100);
+    signal_send_progress_bar_culcradar();
+    return 0;
+}
+
+//переход от частот и углов к дальностям и поперечным координатам
+void culcradar::culc_Fft(cField &field)
+{
+    field = fft3(field, 1);
+    field = reorder3(field);
+    for (size_t iz = 0; iz < field.size(); iz++)
+        for (size_t iy = 0; iy < field[0].size(); iy++)
+            for (size_t ix = 0; ix < field[0][0].size(); ix++)
+                field[iz][iy][ix] = sqrt(4. * Pi / countY) * field[iz][iy][ix];
 }
 
 //запуск задачи вычисления поля по ФО
-int culcradar::culc_Eout(/*bool Aref, double Aphi, double Atheta,
+//расчет поля. освещенность треугольников, рассчитанная для Nin, после
+//расчета заменяется освещенностью из задачи
+int culcradar::culc_Eout()
+{
+    m_clientVisible.clear();
+    int res = culc_Scattered();
+    for (size_t iTr = 0; iTr < m_clientVisible.size(); iTr++)
+        triangles[iTr].setVisible(m_clientVisible[iTr]);
+    m_clientVisible.clear();
+    m_litOn = false;
+    return res;
+}
+
+int culcradar::culc_Scattered(/*bool Aref, double Aphi, double Atheta,
     bool AboolX, bool AboolY, bool AboolZ, double aLmax,
     double AstepX, double AstepY, double AstepZ, double Awave,
     rVect aEin*/)
@@ -576,7 +3035,8 @@ int culcradar::culc_Eout(/*bool Aref, double Aphi, double Atheta,
     //Матрица перехода к системе локатора
     double cosangle = acos(Nin * rVectY);
     rVect aAxis = Nin ^ rVectY;
-    rMatrix SO2, invSO2;
+    rMatrix invSO2;
+    SO2 = rMatrix();
     if (aAxis.norm() > 1e-6)
     {
         aAxis = 1. / aAxis.length()*aAxis;
@@ -585,24 +3045,23 @@ int culcradar::culc_Eout(/*bool Aref, double Aphi, double Atheta,
     invSO2 = transpon(SO2);
     //rVect locNout = invSO2 * Nout;
 
-    double dAngleX(0.);
-    double dAngleZ(0.);
+    dAngleX = 0.;
+    dAngleZ = 0.;
     if (stepX)
         dAngleX = 6. / (wave * stepX * countX);
     if (stepZ)
         dAngleZ = 6. / (wave * stepZ * countZ);
 
-    //вывод нулевого прогресса
-    progress = 0;
+    //вывод нулевого прогресса (этапа)
+    progress = stage_Progress(0);
     float p = 0;
     count = true; //прогресс-бар запущен
     signal_send_progress_bar_culcradar();
 
-    int m = 0;
     uint size1 = vEout[0][0].size();
     uint size2 = vEout[0].size();
     uint size3 = vEout.size();
-    int num_angle = size1 * size2 * size3;
+    size_t num_angle = (size_t)size1 * size2 * size3;
 
     //создание и запуск таймера с периодичностью 1000 мсек
     bool send = false; //флаг разрешения передачи значения прогресс-бара
@@ -615,105 +3074,219 @@ int culcradar::culc_Eout(/*bool Aref, double Aphi, double Atheta,
         ->setInterval(1000) //установка интервала
         ->start();          //запуск
 
-    //чтение рассеянного поля из бинарного файла
+    m_precisionError = -1.;
+    m_engineUsed.clear();
+    //чтение рассеянного поля (после fft) из хранилища результатов
     if (RESULT_FROM_FILE) {
-        //чтение в vEout...
         RESULT_FROM_FILE = false;
+        if (load_Result(culc_Fields())) {
+            m_timer.stop();
+            m_total = num_angle; m_start = num_angle; m_done = num_angle;
+            progress = stage_Progress(100);
+            signal_send_progress_bar_culcradar();
+            return 0;
+        }
+        clogs("результат в хранилище не найден, выполняется расчет","wrn","");
     }
-    else {
-        //цикл по углам и по частотам
-        if (ref)
-        {
-            for (size_t iz = 0; iz < size3; iz++)
-            {
-                for (size_t iy = 0; iy < size2; iy++)
-                {
-                    for (size_t ix = 0; ix < size1; ix++)
-                    {
-                        Nout.fromSphera(1.,
-                                        0.5 * Pi + (1. * ix - 0.5 * (countX - 1)) * dAngleX,
-                                        0.5 * Pi + (1. * iz - 0.5 * (countZ - 1)) * dAngleZ);
-                        Nout = -1.*(SO2 * Nout);
-                        NoutRef = Nout;  NoutRef.setZ(-Nout.getZ());
-                        for (int iTr = 0; iTr < (int)triangles.size(); iTr++)
-                        {
-                            if (triangles[iTr].getVisible())
-                            {
-                                vEout[iz][iy][ix] = vEout[iz][iy][ix] + triangles[iTr].PolarDifraction(Nin,
-                                                                                                       Nout, Ein, wave - (1. * iy - 0.5 * (countY - 1)) * stepW);
-                                vEout[iz][iy][ix] = vEout[iz][iy][ix] + triangles[iTr].PolarDifraction(Nin,
-                                                                                                       NoutRef, Ein, wave - (1. * iy - 0.5 * (countY - 1)) * stepW);
-                                vEout[iz][iy][ix] = vEout[iz][iy][ix] + triangles[iTr].PolarDifraction(NinRef,
-                                                                                                       Nout, Ein, wave - (1. * iy - 0.5 * (countY - 1)) * stepW);
-                                vEout[iz][iy][ix] = vEout[iz][iy][ix] + triangles[iTr].PolarDifraction(NinRef,
-                                                                                                       NoutRef, Ein, wave - (1. * iy - 0.5 * (countY - 1)) * stepW);
-                            }
-                        } //if (triangles[iTr].getVisible())
-                        //Progress bar
-                        auto it = m;
-                        p = (float)(it) / (num_angle - 1);
-                        p *= 100;
-                        m++;
-                        if ((m_timer.isRunning()) && (send)) { //если таймер запущен и передача разрешена
-                            progress = (int)p;
-                            signal_send_progress_bar_culcradar();
-                            send = false;  //установка запрета передачи
-                        }
-                        if (!RUN_C) {
-                            m_timer.stop();
-                            return -1;
-                        }
-                    }//for ix
-                }//for iy
-            }//for iz
-        }//if (ref)
-        else
+    {
+        //продолжение расчета с контрольной точки
+        size_t start = 0;
+        m_total = num_angle;
+        if (load_Checkpoint(start))
+            clogs("расчет продолжен с контрольной точки " + m_checkpoint + " (" +
+                  QString::number(start) + " из " + QString::number(num_angle) + ")","","");
+        m_start = start;
+        m_done = start;
+        auto saved = std::chrono::steady_clock::now();
+        auto sliced = saved;
+        bool slice = false; //слот планировщика удерживается
+
+        //освещенность по Nin - при каждом запуске (и при продолжении с контрольной
+        //точки); освещенность из задачи берется только для ее направления без затенения
+        if (m_occlusion || !m_clientLit) {
+            if (!begin_Slice(0)) {
+                m_timer.stop();
+                return -1;
+            }
+            bool ok = culc_Illumination(m_occlusion);
+            end_Slice();
+            if (!ok) {
+                m_timer.stop();
+                return -1;
+            }
+        }
+        //вся сетка неравномерным fft за один квант
+        bool nufft = false;
+        if ((start == 0) && m_nufft) {
+            if (ref)
+                clogs("неравномерное fft не учитывает подстилающую поверхность, "
+                      "расчет прямым суммированием", "wrn", "");
+            else {
+                if (!begin_Slice(culc_Cost(num_angle) + m_costAhead)) {
+                    m_timer.stop();
+                    return -1;
+                }
+                int r = culc_Nufft();
+                nufft = (r == 0);
+                //погрешность неравномерного fft сверяется с эталоном сразу; при
+                //превышении допуска "accuracy" сетка считается прямым суммированием
+                if (nufft && RUN_C) {
+                    m_precisionError = culc_Verify();
+                    clogs("отклонение неравномерного fft от эталона " +
+                          QString::number(m_precisionError, 'g', 3), "", "");
+                    if (m_precisionError > m_engineTolerance) {
+                        clogs("отклонение неравномерного fft больше допуска " +
+                              QString::number(m_engineTolerance, 'g', 2) + ", расчет прямым суммированием", "wrn", "");
+                        for (cField *field : culc_Fields())
+                            for (auto &plane : *field)
+                                for (auto &line : plane)
+                                    std::fill(line.begin(), line.end(), cVect());
+                        m_precisionError = -1.;
+                        nufft = false;
+                    }
+                }
+                end_Slice();
+                if ((r < 0) || !RUN_C) {
+                    m_timer.stop();
+                    return -1;
+                }
+                if (nufft) start = num_angle;
+            }
+        }
+        //многоугольники и кластеры строятся и при продолжении с контрольной точки
+        m_polygonOn = false;
+        if ((start < num_angle) && m_coplanar) culc_Polygons();
+        m_patchOn = false;
+        if ((start < num_angle) && m_curved) culc_Patches();
+        m_symmetryOn = false;
+        if ((start < num_angle) && m_symmetry) culc_Symmetry();
+        m_clusterOn = false;
+        if ((start < num_angle) && m_cluster) {
+            if (ref)
+                clogs("агрегация кластеров не учитывает подстилающую поверхность, "
+                      "расчет прямым суммированием", "wrn", "");
+            else {
+                if (!begin_Slice(culc_Cost(num_angle - start) + m_costAhead)) {
+                    m_timer.stop();
+                    return -1;
+                }
+                bool ok = culc_Clusters();
+                end_Slice();
+                if (!ok) {
+                    m_timer.stop();
+                    return -1;
+                }
+            }
+        }
+        //портрет только по дальности - блоками по RANGE_SAMPLES частот, каждый
+        //блок за один проход по треугольникам (culc_Range)
+        bool range = (size1 == 1) && (size3 == 1) && (size2 > 1);
+        //сетка с одной частотой - плитками по TILE_DIRS направлений
+        bool dirs = (size2 == 1) && (num_angle > 1);
+        tileKernel kernel = range ? &culcradar::culc_Range : (dirs ? select_DirsKernel() : select_Kernel());
+        size_t tile = range ? RANGE_SAMPLES : (dirs ? TILE_DIRS : TILE_SAMPLES);
+        //цикл по углам и по частотам: m = iy + size2 * (ix + size1 * iz),
+        //частоты одного направления идут подряд
+        for (size_t m = start; m < num_angle; )
         {
-            for (size_t iz = 0; iz < size3; iz++)
-            {
-                for (size_t iy = 0; iy < size2; iy++)
-                {
-                    for (size_t ix = 0; ix < size1; ix++)
-                    {
-                        /*built_Ns_out(0.5 * Pi + (1. * ix - 0.5 * (countX - 1)) * dAngleX,
-                            +0.5 * Pi + (1. * iz - 0.5 * (countZ - 1)) * dAngleZ);
-                        Nout = SO2 * Nout;
-                        NoutRef = SO2 * NoutRef;*/
-                        Nout.fromSphera(1.,
-                                        0.5 * Pi + (1. * ix - 0.5 * (countX - 1)) * dAngleX,
-                                        0.5 * Pi + (1. * iz - 0.5 * (countZ - 1)) * dAngleZ);
-                        Nout = -1.*(SO2 * Nout);
-                        //					NoutRef = Nout;  NoutRef.setZ(-Nout.getZ());
-                        for (int iTr = 0; iTr < (int)triangles.size(); iTr++)
-                        {
-                            if (!RUN_C) return -1;
-                            if (triangles[iTr].getVisible())
-                                vEout[iz][iy][ix] = vEout[iz][iy][ix] + triangles[iTr].PolarDifraction(Nin,
-                                                                                                       Nout, Ein, wave - (1. * iy - 0.5 * (countY - 1)) * stepW);
-                        } //if (triangles[iTr].getVisible())
-
-                        //Progress bar
-                        auto it = m;
-                        p = (float)(it) / (num_angle - 1);
-                        p *= 100;
-                        m++;
-                        if ((m_timer.isRunning()) && (send)) {//если таймер запущен и передача разрешена
-                            progress = (int)p;
-                            signal_send_progress_bar_culcradar();
-                            send = false; //установка запрета передачи
-                        }
-                        if (!RUN_C) {
-                            m_timer.stop();
-                            return -1;
-                        }
-                    }//for ix
-                }//for iy
-            }//for iz
+            if (!slice) {
+                if (!begin_Slice(culc_Cost(num_angle - m) + m_costAhead)) {
+                    m_timer.stop();
+                    save_Checkpoint(m);
+                    return -1;
+                }
+                slice = true;
+                sliced = std::chrono::steady_clock::now();
+            }
+            //плитка не выходит за частоты текущего направления
+            size_t n = dirs ? std::min(tile, num_angle - m) : std::min(tile, size2 - m % size2);
+            (this->*kernel)(m, n);
+            if (!RUN_C) {
+                end_Slice();
+                m_timer.stop();
+                save_Checkpoint(m); //плитка с точки m не досчитана
+                return -1;
+            }
+
+            m += n;
+            m_done = m;
+
+            //Progress bar
+            p = (float)m / num_angle;
+            p *= 100;
+            if ((m_timer.isRunning()) && (send)) { //если таймер запущен и передача разрешена
+                progress = stage_Progress(p);
+                signal_send_progress_bar_culcradar();
+                send = false;  //установка запрета передачи
+            }
+
+            //пауза: фиксируем контрольную точку и ждем продолжения или остановки
+            if (PAUSE_C) {
+                end_Slice(); //на паузе слот отдается другим задачам
+                slice = false;
+                save_Checkpoint(m);
+                signal_send_progress_bar_culcradar();
+                while (PAUSE_C && RUN_C)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                saved = std::chrono::steady_clock::now();
+                if (!RUN_C) {
+                    m_timer.stop();
+                    return -1;
+                }
+            }
+
+            //периодическая контрольная точка
+            if ((CHECKPOINT_INTERVAL > 0) && (std::chrono::steady_clock::now() - saved >
+                                              std::chrono::milliseconds(CHECKPOINT_INTERVAL))) {
+                save_Checkpoint(m);
+                saved = std::chrono::steady_clock::now();
+            }
+
+            //конец кванта: слот возвращается планировщику
+            if (slice && (std::chrono::steady_clock::now() - sliced >
+                          std::chrono::milliseconds(SLICE_MS))) {
+                end_Slice();
+                slice = false;
+            }
+        }
+        if (!nufft && (m_kernel->reduced || m_clusterOn) && RUN_C) {
+            m_precisionError = culc_Verify();
+            QString what = m_clusterOn ? QString("агрегации кластеров") : "ядра " + kernel_Name();
+            clogs("отклонение " + what + " от эталона " +
+                  QString::number(m_precisionError, 'g', 3), "", "");
+        }
+        m_engineUsed = nufft ? QString("nufft") : (m_clusterOn ? QString("cluster") : QString());
+        if (slice) end_Slice();
+        //многократные отражения - после сверки с эталоном, которая их не учитывает
+        if (m_sbr && RUN_C) {
+            if (ref)
+                clogs("SBR не учитывает подстилающую поверхность, многократные отражения не считаются", "wrn", "");
+            else {
+                if (!begin_Slice(0)) {
+                    m_timer.stop();
+                    return -1;
+                }
+                bool ok = culc_Sbr();
+                end_Slice();
+                if (!ok) {
+                    m_timer.stop();
+                    return -1;
+                }
+            }
         }
+        m_clusterOn = false;
+        m_polygonOn = false;
+        for (int f = 0; f < 2; f++) vector<cVect>().swap(m_clusterSamples[f]);
+        vector<polygon>().swap(m_polygons);
+        m_patchOn = false;
+        vector<curvedPatch>().swap(m_patches);
+        m_symmetryOn = false;
+        //расчет завершен, контрольная точка больше не нужна
+        if (!m_checkpoint.isEmpty()) QFile::remove(m_checkpoint);
     }
 
     m_timer.stop(); //остановка таймера
-    progress = 100;
+    progress = stage_Progress(100);
     signal_send_progress_bar_culcradar();
 
     if (SCAT_FIELD_TO_FILE) {
@@ -768,12 +3341,11 @@ int culcradar::culc_Eout(/*bool Aref, double Aphi, double Atheta,
         SCAT_FIELD_TO_FILE = false;
     }
 
-    vEout = fft3(vEout, 1);
-    vEout = reorder3(vEout);
-    for (size_t iz = 0; iz < vEout.size(); iz++)
-        for (size_t iy = 0; iy < vEout[0].size(); iy++)
-            for (size_t ix = 0; ix < vEout[0][0].size(); ix++)
-                vEout[iz][iy][ix] = sqrt(4. * Pi / countY) * vEout[iz][iy][ix];
+    if (!begin_Slice(0)) return -1;
+    for (cField *field : culc_Fields())
+        culc_Fft(*field);
+    end_Slice();
+    store_Result(culc_Fields());
 
     if (FFT_FIELD_TO_FILE) {
 
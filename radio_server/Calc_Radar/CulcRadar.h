@@ -4,15 +4,26 @@
 #include "Calc_Radar/Node.h"
 #include "Calc_Radar/Edge.h"
 #include "Calc_Radar/Triangle.h"
+#include "Calc_Radar/Polygon.h"
+#include "Calc_Radar/CurvedPatch.h"
+#include "Calc_Radar/mesh_decimation.h"
+#include "Calc_Radar/bvh.h"
+#include "Calc_Radar/sbr.h"
+#include "Calc_Radar/worker_pool.h"
 #include "Calc_Radar/Radar_Wave.h"
+#include "Calc_Radar/rMatrix.h"
 #include "rVect.h"
 #include "cVect.h"
 #include <vector>
+#include <atomic>
+#include <functional>
 #include <QJsonObject>
 #include <QJsonArray>
 #include "calctools.h"
 #include "timer.h"
 
+struct solverKernel; //ядро расчета (Calc_Radar/solver_kernels.h)
+
 /*
 Система координат выбрана таким образом, что плоскость XOY расположена горизонтально параллельно земной поверхности.
 ось Z направлена вверх и оси XYZ образуют правую тройку.
@@ -20,6 +31,13 @@
 Все углы передаются в радианах.
 */
 
+class QDataStream;
+
+//комплексное векторное поле на сетке [iz][iy][ix]
+typedef vector<vector<vector<cVect>>> cField;
+//набор полей задачи (по поляризациям падающей волны)
+typedef vector<cField*> cFields;
+
 class culcradar : public QObject
 {
     Q_OBJECT
@@ -31,12 +49,124 @@ protected:
     Timer m_timer;         //таймер прогресс-бара
     int progress;          //значение прогресс-бара
     bool count = false;    //признак запуска прогресс-бара
+    int SLICE_MS;          //длительность кванта расчета, мсек
+
+    //квант расчета: цикл ФО выполняется квантами, между которыми слот
+    //может быть отдан другой задаче. cost - оставшаяся стоимость задачи
+    virtual bool begin_Slice(double cost) { (void)cost; return RUN_C; }
+    virtual void end_Slice() {}
+    //хранилище результатов: поле после fft по ключу задачи
+    virtual bool load_Result(cFields fields) { (void)fields; return false; }
+    virtual void store_Result(cFields fields) { (void)fields; }
+    //число потоков для расчетов, распараллеленных внутри одного кванта
+    virtual int culc_Threads() { return 1; }
+    double culc_Cost(size_t samples); //стоимость расчета samples точек
+    QString culc_Mode(); //режим ядра для модели времени расчета
+    size_t m_start;  //точка, с которой начат текущий расчет
+    std::atomic<size_t> m_done; //число рассчитанных точек (пишется из потоков пула)
+    size_t m_total;  //число точек сетки
+    //многодиапазонная задача: расчет выполняется этапами, по этапу на диапазон
+    int m_stage;        //номер текущего этапа
+    int m_stages;       //число этапов
+    double m_costAhead; //стоимость этапов после текущего
+    const solverKernel *m_kernel; //ядро расчета вклада треугольника
+    double m_precisionError; //отклонение от эталона для ядра пониженной точности
+    //воспроизводимое накопление: результат не зависит от числа потоков
+    //и порядка их работы (фиксированные порции, компенсированное суммирование)
+    bool m_deterministic;
+    //ускоренные методы: неравномерное fft по всей сетке, агрегация кластеров
+    //треугольников; m_engineTolerance - их относительная погрешность
+    bool m_nufft;
+    bool m_cluster;
+    QString m_engineUsed; //метод последнего расчета ("nufft", "cluster", пусто - прямое суммирование)
+    //упрощение модели с допуском m_decimationTolerance длин волн диапазона:
+    //исходные треугольники сохраняются, упрощенная модель строится (или берется
+    //из памяти) для каждого диапазона и остается общей, пока на нее есть ссылки
+    bool m_decimation;
+    double m_decimationTolerance;
+    QString m_modelKey;
+    vector<triangle> m_sourceTriangles;
+    std::shared_ptr<decimatedMesh> m_mesh;
+    //объединение смежных копланарных треугольников в многоугольники
+    bool m_coplanar;
+    bool m_polygonOn;                   //многоугольники используются в расчете
+    vector<polygon> m_polygons;
+    vector<char> m_merged;              //треугольник считается в составе многоугольника
+    //криволинейные элементы второго порядка на месте изогнутых освещенных треугольников
+    bool m_curved;
+    bool m_patchOn;                     //криволинейные элементы используются в расчете
+    vector<curvedPatch> m_patches;
+    vector<char> m_curvedFacet;         //треугольник считается криволинейным элементом
+    //зеркальная симметрия освещенных треугольников относительно плоскости
+    //m_symmetryNormal·r = m_symmetryOffset: для направлений, у которых
+    //Nin - Nout лежит в плоскости, вклады треугольника и его отражения равны,
+    //и считается только один треугольник пары с суммой поляризационных множителей
+    bool m_symmetry;
+    bool m_symmetryDeclared;            //плоскость задана в задаче
+    rVect m_symmetryNormal;
+    double m_symmetryOffset;
+    bool m_symmetryOn;                  //пары найдены
+    double m_symmetryReach;             //наибольшее расстояние вершин пар от плоскости
+    vector<std::pair<size_t, size_t>> m_mirrorPairs; //(считаемый, отраженный)
+    vector<char> m_mirrorSkip;          //отраженный треугольник пары
+    //освещенность треугольников считается для каждого направления падения:
+    //по нормалям и (m_occlusion) лучами к источнику через BVH. на время
+    //расчета она заменяет освещенность из задачи (m_clientVisible), которая
+    //верна только для directVector задачи (m_clientLit) и используется лишь
+    //без затенения; при подстилающей поверхности m_lit - освещенность прямой
+    //(LIT_DIRECT) и отраженной (LIT_REFLECTED) волной
+    bool m_occlusion;
+    bool m_clientLit;
+    bool m_litOn;
+    bool m_litValid;   //m_lit рассчитана для текущих Nin и модели
+    bool m_litShadows; //m_lit рассчитана с затенением
+    vector<char> m_lit;
+    vector<char> m_clientVisible;
+    //BVH треугольников модели: строится при первом затенении или SBR и общий
+    //для ядер с той же моделью (серия ракурсов, упрощенная модель диапазона)
+    std::shared_ptr<const facetBvh> m_bvh;
+    const facetBvh &model_Bvh();
+    //многократные отражения (SBR): вклады выходов лучевых трубок со второго
+    //отражения добавляются к полю ФО
+    bool m_sbr;
+    int m_sbrBounces;
+    double m_sbrDensity;
+    double m_engineTolerance;
+    //кластер - узел октодерева по центрам освещенных треугольников. вклад
+    //кластера, умноженный на exp(-i*w*(Nin-Nout)·centre), гладко зависит от
+    //частоты и углов сетки и задается значениями в узлах Чебышева (pw x px x pz)
+    struct facetCluster {
+        rVect centre;       //фазовый центр
+        double radius;      //наибольшее удаление вершин треугольников от центра
+        size_t begin, end;  //треугольники кластера в m_clusterFacets
+        int child, children; //потомки в m_clusters (children = 0 - лист)
+        int pw, px, pz;     //число узлов интерполяции
+        size_t sample;      //начало значений в узлах в m_clusterSamples
+    };
+    bool m_clusterOn;                   //агрегация используется в плитках
+    vector<facetCluster> m_clusters;    //октодерево
+    vector<size_t> m_clusterFacets;     //освещенные треугольники в порядке узлов
+    vector<int> m_clusterList;          //агрегируемые узлы
+    vector<char> m_clustered;           //треугольник считается в составе кластера
+    vector<cVect> m_clusterSamples[2];  //значения в узлах по полям
+    int stage_Progress(double p); //общий прогресс по прогрессу p текущего этапа
+    workerPool m_pool;  //постоянный пул потоков ядра
+    //size независимых задач пулом из threads потоков; задача получает свой номер
+    //и номер потока пула, добавляет weight точек к m_done. прогресс передается из потока задачи
+    bool culc_Parallel(size_t size, int threads, const std::function<void(size_t, int)> &task, size_t weight);
+    //то же до признака stop: возвращает число выполненных задач (начало диапазона)
+    size_t culc_Until(size_t size, int threads, const std::function<void(size_t, int)> &task,
+                      const std::function<bool()> &stop, size_t weight);
+    //то же квантами планировщика: в квант пулу передаются все оставшиеся задачи,
+    //выдача заканчивается через SLICE_MS или на паузе. ahead - точки последующих этапов
+    bool culc_Sliced(size_t size, const std::function<void(size_t, int)> &task, size_t weight, size_t ahead);
 
 public:
     bool SAVE_MODEL_TO_FILE;
     bool SCAT_FIELD_TO_FILE;
     bool FFT_FIELD_TO_FILE;
     bool RESULT_FROM_FILE;
+    int CHECKPOINT_INTERVAL; //период записи контрольной точки, мсек
 signals:
     void signal_send_progress_bar_culcradar();
 
@@ -48,7 +178,10 @@ signals:
 
 private:
     bool RUN_C; //признак работы
+    std::atomic<bool> PAUSE_C; //признак паузы
+    QString m_checkpoint; //файл контрольной точки (пустая строка - без контрольных точек)
     bool ref;  //признак подстилающий поверхности
+    bool dual; //признак расчета для двух поляризаций падающей волны (матрица рассеяния)
     //	double phi=0., theta=0.;// ракурс. Углы направления на объект. theta УГОЛ МЕСТА
     rVect Nin, Nout, NinRef, NoutRef;
     bool boolX, boolY, boolZ; //по каким осям строится РЛП
@@ -58,6 +191,8 @@ private:
     int countX, countY, countZ; //размерность массива РЛП
     double wave; //волновое число
     double stepW; //шаг по волновым числам
+    rMatrix SO2; //матрица перехода к системе локатора
+    double dAngleX, dAngleZ; //шаг по углам
     //геометрическая модель
     vector<edge*> edges;
     vector<triangle> triangles;
@@ -65,16 +200,35 @@ private:
 
     //падающее поле
     rVect Ein;
+    rVect Ein2; //ортогональная поляризация падающего поля (режим матрицы рассеяния)
+    rVect EinV, EinH; //векторы вертикальной и горизонтальной поляризации
+    //поляризационные множители треугольников для текущего направления рассеяния
+    //[поляризация Ein/Ein2][направление Nout/NoutRef]; не зависят от частоты
+    vector<rVect> m_pol[2][2];
+    rVect m_polDir;   //направление, для которого вычислены множители
+    bool m_polValid;  //множители вычислены для текущих Nin, поляризации и модели
+    bool m_polMirror; //множители пар симметрии сложены (направление в плоскости симметрии)
 
     //рассеянное поле
     vector<vector<vector<cVect>>> vEout;
+    cField vEout2; //рассеянное поле для Ein2
 
     //параметры радара
     radar_wave RWave;
+    vector<int> m_bands; //диапазоны частот задачи
+    vector<rVect> m_aspects; //направления падения серии ракурсов
+    vector<double> m_rcsAngles; //азимуты расчета ЭПР, град.
+    vector<double> m_isarAngles; //азимуты ракурсов ISAR, град.
+    double m_isarPixel; //размер пикселя изображения ISAR, м
+    int m_isarSize;     //число пикселей изображения ISAR по стороне
 
 
 public:
     void Exit() {RUN_C = false;}
+    void Pause(bool pause) {PAUSE_C = pause;}
+    bool isPaused() {return PAUSE_C;}
+    bool isRun() {return RUN_C;}
+    void setCheckpoint(const QString &name) {m_checkpoint = name;}
     void set_ref(bool Ref) { ref=Ref; } //подстилающая поверхность
     //	void set_phi(double Phi) { phi = Phi; }
     //	void set_theta(double Theta) { theta = Theta;}
@@ -116,6 +270,46 @@ public:
 private:
     //выбор размерности массива и шага по волновым числам это отдельная песня
     void culc_count();// countX, countY, countZ; stepW;
+    static int count_Axis(double L, double step); //размерность по одной оси
+
+public:
+    //многодиапазонная задача: модель, освещенность и поляризации общие,
+    //для каждого диапазона меняются волновое число, разрешение и сетка
+    vector<int> get_Bands() { return m_bands; }
+    void set_Band(int band);
+    size_t band_Samples(int band); //число точек сетки диапазона
+
+    //серия ракурсов: модель загружается один раз, ракурсы считаются
+    //отдельными копиями ядра со своим направлением падения
+    vector<rVect> get_Aspects() { return m_aspects; }
+    int set_Direction(rVect In, int inc_polariz, int ref_polariz);
+    void set_Incidence(rVect In);
+    int set_Polariz(int inc_polariz, int ref_polariz);
+    void copy_Model(culcradar &src);
+
+    QString kernel_Name(); //имя выбранного ядра расчета
+    //отклонение расчета ядром пониженной точности от эталона (-1 - не сверялся)
+    double get_PrecisionError() { return m_precisionError; }
+    bool get_Deterministic() { return m_deterministic; }
+    bool get_Nufft() { return m_nufft; }
+    bool get_Cluster() { return m_cluster; }
+    QString get_Engine() { return m_engineUsed; } //метод, которым выполнен последний расчет
+    bool get_Coplanar() { return m_coplanar; }
+    bool get_Curved() { return m_curved; }
+    bool get_Symmetry() { return m_symmetry; }
+    bool get_Occlusion() { return m_occlusion; }
+    bool get_Sbr() { return m_sbr; }
+    //моностатическая ЭПР по азимуту (поворот directVector вокруг оси Z)
+    //на центральной частоте диапазона, без fft
+    vector<double> get_RcsAngles() { return m_rcsAngles; }
+    int culc_Rcs(vector<double> &sigma); //sigma - ЭПР, м2
+
+    //ISAR: спектры ракурсов (поворот directVector вокруг оси Z) по частотам
+    //диапазона, изображение в плоскости XY модели обратным проецированием
+    vector<double> get_IsarAngles() { return m_isarAngles; }
+    size_t isar_Samples(); //число точек задачи ISAR с учетом проецирования
+    //image[iy][ix] - модуль изображения, x0, y0 - координаты пикселя [0][0], м
+    int culc_Isar(vector<vector<double>> &image, double &x0, double &y0, double &pixel);
 
 public:
     //загрузку геометрической модели пока производим из файла obj потом из JSON
@@ -144,8 +338,15 @@ public:
     rVect getEin() { return Ein; }
     void setEin(rVect val) { Ein = val; }
 
+    //поляризации для матрицы рассеяния
+    bool get_dual() { return dual; }
+    rVect getEin2() { return Ein2; }
+    rVect getEinV() { return EinV; }
+    rVect getEinH() { return EinH; }
+
     //рассеянное поле
     cVect getEout(size_t iX, size_t iY, size_t iZ);
+    cVect getEout2(size_t iX, size_t iY, size_t iZ) { return vEout2[iZ][iY][iX]; }
     void setEout(size_t iX, size_t iY, size_t iZ, cVect Eout);
 private:
     void setSizeEout(size_t iX, size_t iY, size_t iZ);
@@ -154,6 +355,66 @@ public:
     int getSizeEoutY() { return vEout[0].size(); }
     int getSizeEoutZ() { return vEout.size(); }
 
+private:
+    //вычисление поля по ФО в плитке из n точек сетки (угол, угол, частота),
+    //начиная с m; точки плитки - частоты одного направления. варианты
+    //по активным угловым осям, подстилающей поверхности и матрице рассеяния
+    //собираются при компиляции, вариант выбирается один раз на задачу
+    template<bool AX, bool AZ, bool REF, bool DUAL> void culc_Tile(size_t m, size_t n);
+    typedef void (culcradar::*tileKernel)(size_t m, size_t n);
+    tileKernel select_Kernel();
+    //плитка сетки с одной частотой: n направлений, блок треугольников - для всех
+    template<bool REF, bool DUAL> void culc_TileDirs(size_t m, size_t n);
+    tileKernel select_DirsKernel();
+    void culc_Polariz(rVect &Nout_, rVect &NoutRef_);
+    void culc_Direction(size_t ix, size_t iz, rVect &Nout_, rVect &NoutRef_); //направление рассеяния точки сетки
+    rVect culc_Direction(double ax, double az); //направление по углам от центра сетки
+    //одномерный портрет по дальности: частоты [m, m + n) за один проход по треугольникам
+    void culc_Range(size_t m, size_t n);
+    double culc_Verify(); //сверка ядра пониженной точности с эталонным
+    bool culc_RangeOrdered(size_t iy0, int n, rVect Nout_); //culc_Range с воспроизводимым накоплением
+    //вся сетка неравномерным fft: 0 - поле рассчитано, 1 - сетка fft слишком
+    //велика (расчет прямым суммированием), -1 - расчет прерван
+    int culc_Nufft();
+    void culc_Polygons(); //объединение копланарных освещенных треугольников
+    void culc_Patches(); //криволинейные элементы по нормалям вершин
+    //пары зеркально симметричных треугольников: плоскость из задачи или
+    //вертикальная плоскость через Nin; false - модель не симметрична
+    bool culc_Symmetry();
+    //освещенность треугольников для Nin: по нормалям и (shadows) с затенением
+    bool culc_Illumination(bool shadows); //false - расчет остановлен
+    char facet_Lit(size_t iTr, rVect In, bool shadows);
+    bool culc_Sbr(); //false - расчет остановлен
+    //вклад треугольника с подстилающей поверхностью (как solverKernel::refSweep)
+    //с учетом освещенности m_lit
+    void facet_RefSweep(size_t iTr, rVect Nout_, double w0, size_t n,
+                        complex<double> *dOut, complex<double> *dRef, complex<double> *tmp);
+    //то же для падения по In с освещенностью lit
+    void facet_RefSweep(size_t iTr, char lit, rVect In, rVect Nout_, double w0, double dW, size_t n,
+                        complex<double> *dOut, complex<double> *dRef, complex<double> *tmp);
+    bool mirror_Pairs(rVect m, double d);
+    //вклад элементов [begin, end) в поля E, E2 на сетке частот w0 - j*stepW
+    void patch_Sweep(size_t begin, size_t end, rVect Nout_, double w0, size_t n,
+                     vector<cVect> &E, vector<cVect> *E2);
+    void decimate_Model(); //упрощенная модель для текущего диапазона
+    //агрегация кластеров: октодерево, выбор кластеров по оценке погрешности,
+    //значения в узлах интерполяции; вклад кластеров в плитку
+    bool culc_Clusters();
+    void split_Cluster(const vector<rVect> &centres, int node, int depth);
+    double select_Clusters(int node, size_t samples);
+    void cluster_Tile(size_t ix, size_t iz, size_t iy0, size_t n, vector<cVect> &E, vector<cVect> *E2);
+    bool range_Clusters(size_t iy0, int n);
+    //контрольная точка: частично заполненное поле и курсор цикла
+    bool save_Checkpoint(size_t cursor);
+    bool load_Checkpoint(size_t &cursor);
+    cFields culc_Fields(); //поля, заполняемые в текущем режиме
+    void culc_Fft(cField &field); //переход от частот и углов к дальностям
+    int culc_Scattered(); //расчет поля (culc_Eout без восстановления освещенности)
+public:
+    //двоичная запись поля (контрольные точки, хранилище результатов)
+    static void write_Field(QDataStream &stream, cField &field);
+    static bool read_Field(QDataStream &stream, cField &field);
+
     radar_wave getRWave() {return RWave;}
     //запуск задачи вычисления поля по ФО
     //углы задаются в радианах. От клиента приходит угол места, polar это полярный угол
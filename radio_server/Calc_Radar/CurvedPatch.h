@@ -0,0 +1,131 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include "rVect.h"
+#include "Triangle.h"
+
+using namespace std;
+
+/*
+Криволинейный треугольник второго порядка: вершины V1, V2, V3 и узлы на
+серединах ребер (12, 23, 31). Узлы ребер восстанавливаются по плоской модели:
+кривая ребра - квадратичная, ее касательные в вершинах перпендикулярны
+нормалям вершин (средним по смежным треугольникам), отсюда
+    m = (a + b)/2 + ((b - a)·(nb - na))/8 * (na + nb)/|na + nb|
+(для дуги окружности - стрелка прогиба с точностью до четвертого порядка).
+Ток ФО на элементе пропорционален нормали, поэтому вклад элемента - векторный
+интеграл
+    N(w) = w/(2Pi) * int exp(i*w*(Nin - Nout)·r) (r_u ^ r_v) du dv,
+а поляризационный множитель линеен по нормали: вклад = sum N_c * P(e_c), где
+P(e_c) - множитель triangle::CulcPolarization для нормали, равной орту e_c.
+интеграл считается квадратурой Гаусса - Лежандра на квадрате, отображенном
+на треугольник (Даффи); число узлов по стороне выбирается по наибольшему
+изменению фазы на элементе
+*/
+
+class curvedPatch
+{
+private:
+    vector<rVect> m_point;   //узлы квадратуры
+    vector<rVect> m_weight;  //вес узла, умноженный на r_u ^ r_v
+    size_t m_facet;          //исходный треугольник
+
+    //узлы и веса Гаусса - Лежандра на [0, 1]
+    static void gauss(int n, vector<double> &x, vector<double> &w)
+    {
+        x.resize(n); w.resize(n);
+        for (int i = 0; i < n; i++) {
+            double z = cos(Pi * (i + 0.75) / (n + 0.5)), dp = 1.;
+            for (int it = 0; it < 100; it++) {
+                double p0 = 1., p1 = z;
+                for (int k = 2; k <= n; k++) {
+                    double p2 = ((2 * k - 1) * z * p1 - (k - 1) * p0) / k;
+                    p0 = p1; p1 = p2;
+                }
+                if (n == 1) { p1 = z; p0 = 1.; }
+                dp = n * (z * p1 - p0) / (z * z - 1.);
+                double dz = p1 / dp;
+                z -= dz;
+                if (fabs(dz) < 1e-15) break;
+            }
+            x[i] = 0.5 * (1. - z);
+            w[i] = 1. / ((1. - z * z) * dp * dp);
+        }
+    }
+
+public:
+    //узел на середине ребра (a, b) по нормалям вершин na, nb
+    static rVect midNode(const rVect &a, const rVect &b, const rVect &na, const rVect &nb)
+    {
+        rVect n = na + nb;
+        double len = n.length();
+        if (len == 0.) return 0.5 * (a + b);
+        return 0.5 * (a + b) + (0.125 * ((b - a) * (nb - na)) / len) * n;
+    }
+
+    //поляризационный множитель для нормали n (как triangle::CulcPolarization)
+    static rVect polarization(rVect n, rVect Nout, rVect p0)
+    {
+        double len = p0.length();
+        rVect s0 = 1. / len * p0;
+        rVect de = (Nout * p0) * s0;
+        rVect dh = Nout ^ s0;
+        return len * ((n ^ dh) - ((n * de) * Nout));
+    }
+
+    //node: V1, V2, V3, середины 12, 23, 31; wmax - наибольшее волновое число
+    curvedPatch(size_t facet, const rVect node[6], double wmax): m_facet(facet)
+    {
+        double size = std::max((node[1] - node[0]).length(),
+                               std::max((node[2] - node[1]).length(), (node[0] - node[2]).length()));
+        //фаза меняется на элементе не больше чем на 2*wmax*size: по четыре
+        //радиана на узел Гаусса и четыре узла на прогиб и якобиан
+        int n = (int)ceil(0.5 * wmax * size) + 4;
+        vector<double> x, w;
+        gauss(n, x, w);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++) {
+                double xi = x[i], eta = x[j];
+                double u = xi * (1. - eta), v = xi * eta;
+                double l0 = 1. - u - v, l1 = u, l2 = v;
+                rVect r = (l0 * (2 * l0 - 1)) * node[0] + (l1 * (2 * l1 - 1)) * node[1] +
+                          (l2 * (2 * l2 - 1)) * node[2] + (4 * l0 * l1) * node[3] +
+                          (4 * l1 * l2) * node[4] + (4 * l2 * l0) * node[5];
+                rVect ru = (-(4 * l0 - 1)) * node[0] + (4 * l1 - 1) * node[1] +
+                           (4 * (l0 - l1)) * node[3] + (4 * l2) * node[4] + (-4 * l2) * node[5];
+                rVect rv = (-(4 * l0 - 1)) * node[0] + (4 * l2 - 1) * node[2] +
+                           (-4 * l1) * node[3] + (4 * l1) * node[4] + (4 * (l0 - l2)) * node[5];
+                m_point.push_back(r);
+                m_weight.push_back((w[i] * w[j] * xi) * (ru ^ rv));
+            }
+    }
+
+    size_t getFacet() { return m_facet; }
+    size_t points() { return m_point.size(); }
+
+    //векторный интеграл на сетке волновых чисел w0 - j*dW: res[3*j + c] - составляющая c
+    void sweep(rVect Nin, rVect Nout, double w0, double dW, int n, complex<double> *res)
+    {
+        const int RESEED = 64;
+        rVect q = Nin - Nout;
+        for (int j = 0; j < 3 * n; j++) res[j] = 0.;
+        for (size_t p = 0; p < m_point.size(); p++) {
+            double phase = q * m_point[p];
+            double wx = m_weight[p].getX(), wy = m_weight[p].getY(), wz = m_weight[p].getZ();
+            complex<double> e, step = exp(-OneI * dW * phase);
+            for (int j = 0; j < n; j++) {
+                if (j % RESEED == 0) e = exp(OneI * (w0 - j * dW) * phase);
+                res[3 * j] += wx * e;
+                res[3 * j + 1] += wy * e;
+                res[3 * j + 2] += wz * e;
+                e *= step;
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            double k = (w0 - j * dW) / (2 * Pi);
+            for (int c = 0; c < 3; c++) res[3 * j + c] *= k;
+        }
+    }//sweep
+};
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "rVect.h"
+#include "cVect.h"
+#include "CPUFFT.h"
+#include "VectFFT.h"
+
+using namespace std;
+
+/*
+Неравномерное быстрое преобразование Фурье третьего типа (Greengard, Lee):
+    f[k] = sum_j c[j] * exp(i * s[k]·x[j])
+для произвольных источников x[j] и точек s[k] с относительной погрешностью tol.
+Источники раскладываются гауссовым ядром на равномерную сетку, сумма по узлам
+сетки вычисляется fft на удвоенной сетке и интерполяцией вторым гауссовым
+ядром в точки s. После fft по оси хранится только полоса частот, в которую
+попадают точки s с ядром интерполяции (около половины сетки). Оси - базис, построенный по точкам s: по осям, вдоль которых
+фаза s·x меняется меньше tol, сетка вырождается в один узел (портрет по
+дальности - одномерное преобразование).
+Раскладка делится на слои сетки по первой оси, интерполяция - на порции точек
+s; задачи независимы, и результат не зависит от их распределения по потокам.
+*/
+
+class nufft3
+{
+private:
+    //параметры оси: сетка nf узлов с шагом h, fft на n2 узлах
+    struct axis {
+        bool active;   //фаза вдоль оси учитывается
+        double xc, X;  //центр и полуширина источников
+        double sc, S;  //центр и полуширина точек s
+        double h, tau; //шаг сетки и параметр ядра раскладки
+        int w, c, nf;  //полуширина ядра, центральный узел, число узлов сетки
+        int n2;        //размер fft
+        double dt, tau2; //шаг по частоте и параметр ядра интерполяции
+        int w2;        //полуширина ядра интерполяции
+        int mlo, q;    //хранимая полоса частот после fft: mlo .. mlo + q - 1
+        double scale;  //h*dt*sqrt(n2)/(sqrt(4*Pi*tau)*sqrt(4*Pi*tau2))
+    };
+    rVect m_e[3];              //базис осей
+    axis m_ax[3];
+    vector<double> m_x[3];     //координаты источников относительно центра
+    vector<double> m_s[3];     //координаты точек s относительно центра
+    vector<complex<double>> m_shift;  //exp(i*sc·x'[j]): сдвиг к центру точек s
+    vector<complex<double>> m_phase;  //exp(i*s[k]·xc): сдвиг к центру источников
+    vector<int> m_l0;          //узел сетки источника по первой оси
+    vector<size_t> m_order;    //источники по узлам первой оси
+    vector<size_t> m_start;    //начало узла в m_order
+    int m_layer;               //узлов первой оси в слое раскладки
+    vector<cVect> m_grid;      //сетка n[0] x n[1] x n[2]: узлы раскладки, после fft - полосы частот
+    vector<cVect> m_next;      //сетка после fft по текущей оси
+    int m_n[3];
+
+    size_t index(int i0, int i1, int i2) {
+        return ((size_t)i0 * m_n[1] + i1) * m_n[2] + i2;
+    }
+
+    //веса ядра раскладки источника x по оси a: узлы l0 - w .. l0 + w,
+    //с делением на преобразование ядра интерполяции в узле
+    void spreadWeights(const axis &a, double x, int l0, double *wt) {
+        if (!a.active) { wt[0] = 1.; return; }
+        for (int d = -a.w; d <= a.w; d++) {
+            double xl = (l0 + d - a.c) * a.h;
+            wt[d + a.w] = exp(-(xl - x) * (xl - x) / (4. * a.tau) + a.tau2 * xl * xl);
+        }
+    }
+
+    //веса ядра интерполяции в точку s по оси a с множителем fft exp(-i*2Pi*m*c/n2)
+    int interpWeights(const axis &a, double s, complex<double> *wt) {
+        if (!a.active) { wt[0] = 1.; return 0; }
+        int m0 = (int)floor(s / a.dt + 0.5);
+        for (int d = -a.w2; d <= a.w2; d++) {
+            int m = m0 + d;
+            double u = s - m * a.dt;
+            wt[d + a.w2] = exp(-u * u / (4. * a.tau2)) *
+                           exp(-OneI * (2. * Pi * m * a.c / a.n2));
+        }
+        return m0;
+    }
+
+public:
+    //x - источники, s - точки, tol - относительная погрешность
+    nufft3(const vector<rVect> &x, const vector<rVect> &s, double tol)
+    {
+        //базис: первая ось по среднему s, вторая - по наибольшему отклонению от него
+        rVect mean;
+        for (size_t k = 0; k < s.size(); k++) mean = mean + s[k];
+        m_e[0] = (mean.length() > 0.) ? 1. / mean.length() * mean : rVect(1., 0., 0.);
+        rVect dev = (fabs(m_e[0].getX()) < 0.9) ? rVect(1., 0., 0.) : rVect(0., 1., 0.);
+        dev = dev - (dev * m_e[0]) * m_e[0];
+        //отклонения на уровне округления направления не задают
+        double best = 1e-9 * mean.length() / std::max<size_t>(1, s.size());
+        for (size_t k = 0; k < s.size(); k++) {
+            rVect d = s[k] - (s[k] * m_e[0]) * m_e[0];
+            if (d.length() > best) { best = d.length(); dev = d; }
+        }
+        dev = dev - (dev * m_e[0]) * m_e[0];
+        m_e[1] = 1. / dev.length() * dev;
+        m_e[2] = m_e[0] ^ m_e[1];
+
+        //ширина ядер: exp(-L) на границе; запас в единицу подобран по сравнению
+        //с прямым суммированием (погрешность не выше tol при tol = 1e-3..1e-9)
+        double L = log(1. / tol) + 1.;
+        for (int d = 0; d < 3; d++) {
+            axis &a = m_ax[d];
+            double xmin = 1e300, xmax = -1e300, smin = 1e300, smax = -1e300;
+            m_x[d].resize(x.size());
+            m_s[d].resize(s.size());
+            for (size_t j = 0; j < x.size(); j++) {
+                m_x[d][j] = x[j] * m_e[d];
+                xmin = std::min(xmin, m_x[d][j]); xmax = std::max(xmax, m_x[d][j]);
+            }
+            for (size_t k = 0; k < s.size(); k++) {
+                m_s[d][k] = s[k] * m_e[d];
+                smin = std::min(smin, m_s[d][k]); smax = std::max(smax, m_s[d][k]);
+            }
+            if (x.empty()) { xmin = xmax = 0.; }
+            if (s.empty()) { smin = smax = 0.; }
+            a.xc = 0.5 * (xmin + xmax); a.X = 0.5 * (xmax - xmin);
+            a.sc = 0.5 * (smin + smax); a.S = 0.5 * (smax - smin);
+            for (size_t j = 0; j < x.size(); j++) m_x[d][j] -= a.xc;
+            for (size_t k = 0; k < s.size(); k++) m_s[d][k] -= a.sc;
+
+            a.active = (a.X * a.S > tol);
+            a.h = a.tau = a.dt = a.tau2 = 0.;
+            a.w = a.c = a.w2 = a.mlo = 0;
+            a.nf = a.n2 = a.q = 1;
+            a.scale = 1.;
+            if (!a.active) continue;
+            //раскладка с двукратным запасом по частоте: h = Pi/(2S)
+            a.h = Pi / (2. * a.S);
+            a.tau = L / (8. * a.S * a.S);
+            a.w = (int)ceil(sqrt(4. * a.tau * L) / a.h);
+            a.c = (int)ceil(a.X / a.h) + a.w;
+            a.nf = 2 * a.c + 1;
+            //интерполяция с fft на сетке не менее чем вдвое большей
+            a.n2 = (int)pad2(2 * a.nf);
+            double Xg = a.c * a.h;
+            double Y = a.n2 * a.h - Xg;
+            a.tau2 = L / (Y * Y - Xg * Xg);
+            a.dt = 2. * Pi / (a.n2 * a.h);
+            a.w2 = (int)ceil(sqrt(4. * a.tau2 * L) / a.dt);
+            int mmax = (int)ceil(a.S / a.dt) + a.w2;
+            a.q = 2 * mmax + 1;
+            a.mlo = -mmax;
+            a.scale = a.h * a.dt * sqrt((double)a.n2) / sqrt(4. * Pi * a.tau) /
+                      sqrt(4. * Pi * a.tau2);
+        }
+
+        m_shift.resize(x.size());
+        for (size_t j = 0; j < x.size(); j++) {
+            double p = 0.;
+            for (int d = 0; d < 3; d++) p += m_ax[d].sc * m_x[d][j];
+            m_shift[j] = exp(OneI * p);
+        }
+        m_phase.resize(s.size());
+        for (size_t k = 0; k < s.size(); k++) {
+            double p = 0.;
+            for (int d = 0; d < 3; d++) p += (m_ax[d].sc + m_s[d][k]) * m_ax[d].xc;
+            m_phase[k] = exp(OneI * p);
+        }
+
+        //источники по узлам первой оси: слой раскладки берет только соседние узлы
+        const axis &a0 = m_ax[0];
+        m_l0.resize(x.size());
+        m_start.assign(a0.nf + 1, 0);
+        for (size_t j = 0; j < x.size(); j++) {
+            m_l0[j] = a0.active ? (int)floor(m_x[0][j] / a0.h + 0.5) + a0.c : 0;
+            m_start[m_l0[j] + 1]++;
+        }
+        for (int l = 0; l < a0.nf; l++) m_start[l + 1] += m_start[l];
+        m_order.resize(x.size());
+        vector<size_t> pos(m_start.begin(), m_start.end() - 1);
+        for (size_t j = 0; j < x.size(); j++) m_order[pos[m_l0[j]]++] = j;
+        m_layer = 2 * a0.w + 1;
+    }
+
+    //наибольшее число узлов сетки при преобразовании
+    double gridPoints() {
+        double n = (double)m_ax[0].nf * m_ax[1].nf * m_ax[2].nf;
+        for (int d = 2; d >= 0; d--)
+            n = std::max(n, n / m_ax[d].nf * m_ax[d].q);
+        return n;
+    }
+
+    //число задач раскладки (слоев сетки по первой оси)
+    size_t layers() {
+        return (m_ax[0].nf + m_layer - 1) / m_layer;
+    }
+
+    //обнуление сетки перед раскладкой новых интенсивностей
+    void begin() {
+        for (int d = 0; d < 3; d++) m_n[d] = m_ax[d].nf;
+        m_grid.assign((size_t)m_n[0] * m_n[1] * m_n[2], cVect());
+    }
+
+    //раскладка интенсивностей c на узлы слоя layer
+    void spread(const vector<cVect> &c, size_t layer) {
+        const axis &a0 = m_ax[0], &a1 = m_ax[1], &a2 = m_ax[2];
+        int p0 = (int)layer * m_layer;
+        int p1 = std::min(a0.nf, p0 + m_layer);
+        vector<double> w0(2 * a0.w + 1), w1(2 * a1.w + 1), w2(2 * a2.w + 1);
+        for (int l = std::max(0, p0 - a0.w); l < std::min(a0.nf, p1 + a0.w); l++)
+            for (size_t o = m_start[l]; o < m_start[l + 1]; o++) {
+                size_t j = m_order[o];
+                int l1 = a1.active ? (int)floor(m_x[1][j] / a1.h + 0.5) + a1.c : 0;
+                int l2 = a2.active ? (int)floor(m_x[2][j] / a2.h + 0.5) + a2.c : 0;
+                spreadWeights(a0, m_x[0][j], l, w0.data());
+                spreadWeights(a1, m_x[1][j], l1, w1.data());
+                spreadWeights(a2, m_x[2][j], l2, w2.data());
+                cVect cj = m_shift[j] * c[j];
+                for (int d0 = std::max(-a0.w, p0 - l); d0 <= std::min(a0.w, p1 - 1 - l); d0++)
+                    for (int d1 = -a1.w; d1 <= a1.w; d1++) {
+                        double w01 = w0[d0 + a0.w] * w1[d1 + a1.w];
+                        cVect *g = &m_grid[index(l + d0, l1 + d1, l2 - a2.w)];
+                        for (int d2 = 0; d2 <= 2 * a2.w; d2++)
+                            g[d2] = g[d2] + (w01 * w2[d2]) * cj;
+                    }
+            }
+    }
+
+    //fft по оси d: nf узлов раскладки -> q частот полосы. строки оси
+    //преобразуются независимо (lines задач transformLine между beginAxis и endAxis)
+    bool active(int d) { return m_ax[d].active; }
+    void beginAxis(int d) {
+        size_t n = (size_t)m_n[0] * m_n[1] * m_n[2] / m_n[d];
+        m_next.assign(n * m_ax[d].q, cVect());
+    }
+    size_t lines(int d) {
+        return (size_t)m_n[0] * m_n[1] * m_n[2] / m_n[d];
+    }
+    void transformLine(int d, size_t k) {
+        const axis &a = m_ax[d];
+        int o1 = (d == 0) ? 1 : 0, o2 = (d == 2) ? 1 : 2; //две другие оси
+        int i[3], n[3] = { m_n[0], m_n[1], m_n[2] };
+        n[d] = a.q;
+        i[o1] = (int)(k / m_n[o2]);
+        i[o2] = (int)(k % m_n[o2]);
+        vector<cVect> line(a.n2);
+        for (i[d] = 0; i[d] < a.nf; i[d]++)
+            line[i[d]] = m_grid[index(i[0], i[1], i[2])];
+        line = fft(line, 1);
+        for (i[d] = 0; i[d] < a.q; i[d]++)
+            m_next[((size_t)i[0] * n[1] + i[1]) * n[2] + i[2]] =
+                line[((a.mlo + i[d]) % a.n2 + a.n2) % a.n2];
+    }
+    void endAxis(int d) {
+        m_grid.swap(m_next);
+        m_next.clear();
+        m_n[d] = m_ax[d].q;
+    }
+
+    //fft сетки по трем осям в одном потоке
+    void transform() {
+        for (int d = 2; d >= 0; d--) {
+            if (!active(d)) continue;
+            beginAxis(d);
+            for (size_t k = 0; k < lines(d); k++) transformLine(d, k);
+            endAxis(d);
+        }
+    }
+
+    //сумма в точках s[k], k0 <= k < k1
+    void interpolate(size_t k0, size_t k1, vector<cVect> &f) {
+        const axis &a0 = m_ax[0], &a1 = m_ax[1], &a2 = m_ax[2];
+        vector<complex<double>> w0(2 * a0.w2 + 1), w1(2 * a1.w2 + 1), w2(2 * a2.w2 + 1);
+        for (size_t k = k0; k < k1; k++) {
+            int m0 = interpWeights(a0, m_s[0][k], w0.data());
+            int m1 = interpWeights(a1, m_s[1][k], w1.data());
+            int m2 = interpWeights(a2, m_s[2][k], w2.data());
+            cVect sum;
+            for (int d0 = 0; d0 <= 2 * a0.w2; d0++)
+                for (int d1 = 0; d1 <= 2 * a1.w2; d1++) {
+                    const cVect *g = &m_grid[index(m0 + d0 - a0.w2 - a0.mlo,
+                                                   m1 + d1 - a1.w2 - a1.mlo,
+                                                   m2 - a2.w2 - a2.mlo)];
+                    cVect row;
+                    for (int d2 = 0; d2 <= 2 * a2.w2; d2++)
+                        row = row + w2[d2] * g[d2];
+                    sum = sum + (w0[d0] * w1[d1]) * row;
+                }
+            //деление на преобразование ядра раскладки
+            double deconv = 1.;
+            for (int d = 0; d < 3; d++)
+                if (m_ax[d].active)
+                    deconv *= m_ax[d].scale * exp(m_ax[d].tau * m_s[d][k] * m_s[d][k]);
+            f[k] = (deconv * m_phase[k]) * sum;
+        }
+    }
+};
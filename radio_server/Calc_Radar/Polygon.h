@@ -0,0 +1,106 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include "rVect.h"
+#include "Triangle.h"
+
+using namespace std;
+
+/*
+Плоский многоугольник из смежных треугольников с общей нормалью (возможно,
+с отверстиями). Дифракционный интеграл по многоугольнику сводится к сумме
+по ребрам границы (формула Гордона): для k = w*(Nin - Nout) и касательной
+к плоскости составляющей kt
+    int exp(i*k·r) dS = -i/|kt|^2 * sum (k·(b - a)^n) * exp(i*k·m) * sinc(k·(b - a)/2),
+a, b - концы ребра, обход против часовой стрелки относительно нормали n,
+m - середина ребра. внутренние ребра разбиения в сумму не входят, ребра
+отверстий обходятся в обратную сторону и учитываются той же формулой.
+вблизи зеркального направления (|kt| -> 0) слагаемые взаимно сокращаются,
+и интеграл считается суммой по исходным треугольникам
+*/
+
+class polygon
+{
+private:
+    //граница: середины ребер, векторы ребер (b - a) и (b - a)^n
+    vector<rVect> m_mid, m_d, m_u;
+    rVect m_normal;
+    double m_size;              //наибольшее расстояние между вершинами (оценка сверху)
+    size_t m_facet;             //треугольник с поляризационным множителем многоугольника
+    vector<triangle> m_facets;  //исходные треугольники (зеркальное направление)
+
+public:
+    //|kt|*m_size, ниже которого интеграл считается по треугольникам
+    static constexpr double SPECULAR = 1e-3;
+
+    polygon(size_t facet, const rVect &normal): m_normal(normal), m_size(0.), m_facet(facet) {}
+
+    void addFacet(const triangle &tr) { m_facets.push_back(tr); }
+    void addEdge(const rVect &a, const rVect &b)
+    {
+        rVect d = b - a;
+        m_mid.push_back(0.5 * (a + b));
+        m_d.push_back(d);
+        m_u.push_back(d ^ m_normal);
+        m_size += d.length() / 2;  //половина периметра не меньше диаметра
+    }
+    size_t getFacet() { return m_facet; }
+    size_t edgeCount() { return m_d.size(); }
+    size_t facetCount() { return m_facets.size(); }
+
+    //дифракционный интеграл на сетке волновых чисел w0 - j*dW (как triangle::DifractionSweep)
+    void DifractionSweep(rVect Nin, rVect Nout, double w0, double dW, int n, complex<double> *res)
+    {
+        const int RESEED = 64;
+        rVect q = Nin - Nout;
+        rVect qt = q - (q * m_normal) * m_normal;
+        double qt2 = qt * qt;
+        for (int j = 0; j < n; j++) res[j] = 0.;
+        for (size_t e = 0; e < m_d.size(); e++) {
+            double c = q * m_u[e], p = q * m_mid[e], s = 0.5 * (q * m_d[e]);
+            complex<double> ep, es;
+            complex<double> sp = exp(-OneI * dW * p), ss = exp(-OneI * dW * s);
+            for (int j = 0; j < n; j++) {
+                double wave = w0 - j * dW;
+                if (j % RESEED == 0) {
+                    ep = exp(OneI * wave * p);
+                    es = exp(OneI * wave * s);
+                }
+                double x = wave * s;
+                double sinc = (fabs(x) < 1e-4) ? 1. - x * x / 6. : es.imag() / x;
+                res[j] += c * sinc * ep;
+                ep *= sp; es *= ss;
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            double wave = w0 - j * dW;
+            if (wave * sqrt(qt2) * m_size < SPECULAR) {
+                res[j] = 0.;
+                for (size_t t = 0; t < m_facets.size(); t++)
+                    res[j] += m_facets[t].Difraction(Nin, Nout, wave);
+            }
+            else
+                res[j] *= -OneI / (2 * Pi * qt2);
+        }
+    }//DifractionSweep
+
+    //с подстилающей поверхностью: dOut, dRef как в solverKernel::refSweep
+    void refSweep(rVect Nin, rVect Nout, double w0, double dW, int n,
+                  complex<double> *dOut, complex<double> *dRef, complex<double> *tmp)
+    {
+        rVect NinRef(Nin.getX(), Nin.getY(), -Nin.getZ());
+        rVect NoutRef(Nout.getX(), Nout.getY(), -Nout.getZ());
+        DifractionSweep(Nin, Nout, w0, dW, n, dOut);
+        DifractionSweep(Nin, NoutRef, w0, dW, n, dRef);
+        if (fabs(Nin.getZ() + Nout.getZ()) <= 1.e-12)
+            for (int j = 0; j < n; j++) dOut[j] += dRef[j];
+        else {
+            DifractionSweep(NinRef, Nout, w0, dW, n, tmp);
+            for (int j = 0; j < n; j++) dOut[j] += tmp[j];
+        }
+        DifractionSweep(NinRef, NoutRef, w0, dW, n, tmp);
+        for (int j = 0; j < n; j++) dRef[j] += tmp[j];
+    }//refSweep
+};
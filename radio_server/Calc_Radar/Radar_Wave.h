@@ -20,6 +20,7 @@ private:
     int m_ref_polariz;    //0-вертик., 1 - гориз.
 public:
     int setPolariz(int &inc_polar, int &ref_polar, rVect &Nin, rVect &Ein);
+    int getBand() {return m_freqband;}
     int getIncPolariz() {return m_inc_polariz;}
     int getRefPolariz() {return m_ref_polariz;}
     double getLambda(){return lambda;}
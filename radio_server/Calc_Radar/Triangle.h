@@ -66,7 +66,7 @@ public:
 			return phase*c/(a*b)*(exp(OneI*b)*(1.-OneI*b)-1.);
 //		return phase*c/(a*b)*exp(OneI*b)*OneI*(a-b);
 		else if ((abs(a)>delta)&&(abs(b)<=delta))
-			return phase*c/((a-b)*a)*(1.-exp(OneI*a)-OneI*a);
+			return phase*c/((a-b)*a)*(1.+OneI*a-exp(OneI*a));
 		else if ((abs(a)<=delta)&&(abs(b)>delta))
 			return phase*c/((a-b)*b)*(exp(OneI*b)-OneI*b-1.);
 		else 
@@ -74,6 +74,91 @@ public:
 	
 	}//Difraction
 
+//     w0 - j*dW, j = 0..n-1 (res[j])
+	//   ,   RESEED  - ,
+	//    ;   ,   Difraction
+	void DifractionSweep(rVect Nin, rVect Nout, double w0, double dW, int n, complex<double> *res)
+	{
+		const int RESEED=64;
+		rVect v2=*m_V2-*m_V1; 
+		rVect v3=*m_V3-*m_V1;
+		rVect q=Nin-Nout;
+		double qa=q*v3, qb=q*v2, q1=q*(*m_V1);
+		double c = (v2^v3).length();
+		complex<double> ea, eb, e1;
+		complex<double> sa=exp(-OneI*dW*qa), sb=exp(-OneI*dW*qb), s1=exp(-OneI*dW*q1);
+		for (int j=0; j<n; j++)
+		{
+			double wave=w0-j*dW;
+			if (j%RESEED==0)
+			{
+				ea=exp(OneI*wave*qa);
+				eb=exp(OneI*wave*qb);
+				e1=exp(OneI*wave*q1);
+			}
+			res[j]=Integral(wave*qa, wave*qb, c, wave/(2*Pi)*e1, ea, eb);
+			ea*=sa; eb*=sb; e1*=s1;
+		}
+	}//DifractionSweep
+
+//      ( Difraction)
+	//a, b -   V3, V2  V1, ea = exp(i*a), eb = exp(i*b)
+	static complex<double> Integral(double a, double b, double c,
+									complex<double> phase, complex<double> ea, complex<double> eb)
+	{
+		const double delta=5.e-3;  //   
+		if ((abs(a)<=delta)&&(abs(b)<=delta)&&(abs(a-b)<=delta))
+			return phase*0.5*c*(1.+0.5*(a+b));
+		else  if ((abs(a)>delta)&&(abs(b)>delta)&&(abs(a-b)<=delta))
+			return phase*c/(a*b)*(eb*(1.-OneI*b)-1.);
+		else if ((abs(a)>delta)&&(abs(b)<=delta))
+			return phase*c/((a-b)*a)*(1.+OneI*a-ea);
+		else if ((abs(a)<=delta)&&(abs(b)>delta))
+			return phase*c/((a-b)*b)*(eb-OneI*b-1.);
+		else 
+			return phase*c/(a*b)*((a*eb-b*ea)/(a-b)-1.);
+	}//Integral
+
+//    (  )
+	//dOut = D(Nin,Nout)+D(NinRef,Nout), dRef = D(Nin,NoutRef)+D(NinRef,NoutRef).
+	//  Nin-Nout    
+	//(+-Nin.z +-Nout.z),      
+	//     : 9   12,  
+	//  (Nout.z = -Nin.z) - 6,     
+	void DifractionRef(rVect Nin, rVect Nout, double wave,
+					   complex<double> &dOut, complex<double> &dRef)
+	{
+		rVect v2=*m_V2-*m_V1; 
+		rVect v3=*m_V3-*m_V1;
+		double c = (v2^v3).length();
+		double qx=Nin.getX()-Nout.getX(), qy=Nin.getY()-Nout.getY();
+		double zi=Nin.getZ(), zo=Nout.getZ();
+		bool mono = abs(zi+zo)<=1.e-12;
+		//       : V1, v3 (a), v2 (b)
+		double h1=wave*(qx*m_V1->getX()+qy*m_V1->getY());
+		double ha=wave*(qx*v3.getX()+qy*v3.getY());
+		double hb=wave*(qx*v2.getX()+qy*v2.getY());
+		double i1=wave*zi*m_V1->getZ(), ia=wave*zi*v3.getZ(), ib=wave*zi*v2.getZ();
+		double o1=wave*zo*m_V1->getZ(), oa=wave*zo*v3.getZ(), ob=wave*zo*v2.getZ();
+		complex<double> H1=exp(OneI*h1), Ha=exp(OneI*ha), Hb=exp(OneI*hb);
+		complex<double> I1=exp(OneI*i1), Ia=exp(OneI*ia), Ib=exp(OneI*ib);
+		complex<double> O1, Oa, Ob;
+		if (mono) { O1=conj(I1); Oa=conj(Ia); Ob=conj(Ib); }
+		else { O1=exp(OneI*o1); Oa=exp(OneI*oa); Ob=exp(OneI*ob); }
+		double k=wave/(2*Pi);
+		//(Nin, Nout): +zi -zo
+		complex<double> d1=Integral(ha+ia-oa, hb+ib-ob, c, k*H1*I1*conj(O1), Ha*Ia*conj(Oa), Hb*Ib*conj(Ob));
+		//(NinRef, NoutRef): -zi +zo
+		complex<double> d4=Integral(ha-ia+oa, hb-ib+ob, c, k*H1*conj(I1)*O1, Ha*conj(Ia)*Oa, Hb*conj(Ib)*Ob);
+		//(Nin, NoutRef): +zi +zo
+		complex<double> d3=Integral(ha+ia+oa, hb+ib+ob, c, k*H1*I1*O1, Ha*Ia*Oa, Hb*Ib*Ob);
+		//(NinRef, Nout): -zi -zo
+		complex<double> d2 = mono ? d3 :
+			Integral(ha-ia-oa, hb-ib-ob, c, k*H1*conj(I1)*conj(O1), Ha*conj(Ia)*conj(Oa), Hb*conj(Ib)*conj(Ob));
+		dOut=d1+d2;
+		dRef=d3+d4;
+	}//DifractionRef
+
 // 
 	//   
 	rVect CulcPolarization(rVect Nin, rVect Nout, //   
@@ -95,4 +180,16 @@ public:
 	{
 		return Difraction(Nin, Nout, wave)*CulcPolarization(Nin, Nout, p0);
 	}
+
+//     
+	//    ,   -   
+	void PolarDifraction2(rVect Nin, rVect Nout, //   
+						 rVect p0, rVect p1,      // . .
+						 double wave,				// 
+						 cVect &E0, cVect &E1)		//   p0  p1
+	{
+		complex<double> d = Difraction(Nin, Nout, wave);
+		E0 = d*CulcPolarization(Nin, Nout, p0);
+		E1 = d*CulcPolarization(Nin, Nout, p1);
+	}
 };
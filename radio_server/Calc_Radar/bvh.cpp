@@ -0,0 +1,205 @@
+#include "Calc_Radar/bvh.h"
+#include <algorithm>
+#include <limits>
+
+//наибольшее число треугольников в листе и глубина дерева
+static const size_t BVH_LEAF = 4;
+static const int BVH_DEPTH = 64;
+
+
+void facetBvh::build(std::vector<triangle> &triangles)
+{
+    size_t size = triangles.size();
+    m_nodes.clear();
+    m_index.resize(size);
+    m_vert.resize(9 * size);
+    std::vector<double> centres(3 * size);
+    for (size_t i = 0; i < size; i++) {
+        node *v[3] = { triangles[i].getV1(), triangles[i].getV2(), triangles[i].getV3() };
+        for (int k = 0; k < 3; k++) {
+            m_vert[9 * i + 3 * k] = v[k]->getX();
+            m_vert[9 * i + 3 * k + 1] = v[k]->getY();
+            m_vert[9 * i + 3 * k + 2] = v[k]->getZ();
+        }
+        for (int a = 0; a < 3; a++)
+            centres[3 * i + a] = (m_vert[9 * i + a] + m_vert[9 * i + 3 + a] + m_vert[9 * i + 6 + a]) / 3.;
+        m_index[i] = i;
+    }
+    if (size == 0) return;
+    m_nodes.reserve(2 * size / BVH_LEAF + 1);
+    split(centres, 0, size, 0);
+}
+
+
+//узел по треугольникам m_index[first, first + count); возвращает его номер
+size_t facetBvh::split(std::vector<double> &centres, size_t first, size_t count, int depth)
+{
+    size_t id = m_nodes.size();
+    m_nodes.push_back(bvhNode());
+    double clo[3], chi[3];
+    for (int a = 0; a < 3; a++) {
+        m_nodes[id].lo[a] = clo[a] = std::numeric_limits<double>::max();
+        m_nodes[id].hi[a] = chi[a] = -std::numeric_limits<double>::max();
+    }
+    for (size_t i = first; i < first + count; i++) {
+        size_t f = m_index[i];
+        for (int a = 0; a < 3; a++) {
+            for (int k = 0; k < 3; k++) {
+                m_nodes[id].lo[a] = std::min(m_nodes[id].lo[a], m_vert[9 * f + 3 * k + a]);
+                m_nodes[id].hi[a] = std::max(m_nodes[id].hi[a], m_vert[9 * f + 3 * k + a]);
+            }
+            clo[a] = std::min(clo[a], centres[3 * f + a]);
+            chi[a] = std::max(chi[a], centres[3 * f + a]);
+        }
+    }
+    m_nodes[id].first = first;
+    m_nodes[id].count = count;
+    m_nodes[id].right = 0;
+    if ((count <= BVH_LEAF) || (depth >= BVH_DEPTH)) return id;
+
+    int axis = 0;
+    for (int a = 1; a < 3; a++)
+        if (chi[a] - clo[a] > chi[axis] - clo[axis]) axis = a;
+    if (chi[axis] <= clo[axis]) return id; //центры совпадают
+    double mid = 0.5 * (clo[axis] + chi[axis]);
+    size_t *begin = &m_index[first];
+    size_t *part = std::partition(begin, begin + count,
+                                  [&](size_t f) { return centres[3 * f + axis] < mid; });
+    size_t left = part - begin;
+    if ((left == 0) || (left == count)) {
+        //несимметричное распределение: деление по медиане
+        left = count / 2;
+        std::nth_element(begin, begin + left, begin + count, [&](size_t a, size_t b) {
+            return centres[3 * a + axis] < centres[3 * b + axis];
+        });
+    }
+    m_nodes[id].count = 0;
+    split(centres, first, left, depth + 1);
+    size_t right = split(centres, first + left, count - left, depth + 1);
+    m_nodes[id].right = right;
+    return id;
+}
+
+
+//пересечение луча с параллелепипедом узла на отрезке (0, tmax)
+bool facetBvh::box(const bvhNode &node, const double *o, const double *inv, double tmax)
+{
+    double t0 = 0., t1 = tmax;
+    for (int a = 0; a < 3; a++) {
+        double ta = (node.lo[a] - o[a]) * inv[a];
+        double tb = (node.hi[a] - o[a]) * inv[a];
+        if (ta > tb) std::swap(ta, tb);
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+
+
+//пересечение луча с треугольником facet (Моллер, Трумбор) на отрезке (0, tmax)
+bool facetBvh::hit(size_t facet, const double *o, const double *d, double tmax, double &t) const
+{
+    const double *v = &m_vert[9 * facet];
+    double e1[3] = { v[3] - v[0], v[4] - v[1], v[5] - v[2] };
+    double e2[3] = { v[6] - v[0], v[7] - v[1], v[8] - v[2] };
+    double p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+    double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (fabs(det) < 1e-300) return false;
+    double inv = 1. / det;
+    double s[3] = { o[0] - v[0], o[1] - v[1], o[2] - v[2] };
+    double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+    if ((u < 0.) || (u > 1.)) return false;
+    double q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+    double w = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv;
+    if ((w < 0.) || (u + w > 1.)) return false;
+    t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+    return (t > 0.) && (t < tmax);
+}
+
+
+bool facetBvh::occluded(const rVect &origin, const rVect &dir, double tmax, size_t skip) const
+{
+    return occludedPacket(&origin, 1, dir, &tmax, skip) != 0;
+}
+
+
+unsigned facetBvh::occludedPacket(const rVect *origin, int count, const rVect &dir,
+                                  const double *tmax, size_t skip) const
+{
+    if (m_nodes.empty() || (count <= 0)) return 0;
+    rVect dv = dir;
+    double d[3] = { dv.getX(), dv.getY(), dv.getZ() };
+    double inv[3];
+    for (int a = 0; a < 3; a++) inv[a] = 1. / d[a]; //деление на 0 дает бесконечность
+    std::vector<double> o(3 * count);
+    for (int i = 0; i < count; i++) {
+        rVect r = origin[i];
+        o[3 * i] = r.getX(); o[3 * i + 1] = r.getY(); o[3 * i + 2] = r.getZ();
+    }
+    unsigned all = (count >= 32) ? ~0u : ((1u << count) - 1);
+    unsigned shadow = 0;
+    size_t stack[2 * BVH_DEPTH + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const bvhNode &node = m_nodes[stack[--top]];
+        unsigned active = 0;
+        for (int i = 0; i < count; i++)
+            if (!(shadow & (1u << i)) && box(node, &o[3 * i], inv, tmax[i])) active |= 1u << i;
+        if (!active) continue;
+        if (node.count > 0) {
+            for (size_t k = node.first; k < node.first + node.count; k++) {
+                size_t f = m_index[k];
+                if (f == skip) continue;
+                for (int i = 0; i < count; i++) {
+                    double t;
+                    if ((active & (1u << i)) && !(shadow & (1u << i)) && hit(f, &o[3 * i], d, tmax[i], t))
+                        shadow |= 1u << i;
+                }
+            }
+            if (shadow == all) return shadow;
+            continue;
+        }
+        stack[top++] = node.right;
+        stack[top++] = &node - &m_nodes[0] + 1;
+    }
+    return shadow;
+}
+
+
+bool facetBvh::intersect(const rVect &origin, const rVect &dir, double tmax, size_t skip,
+                         double &t, size_t &facet) const
+{
+    if (m_nodes.empty()) return false;
+    rVect ov = origin, dv = dir;
+    double o[3] = { ov.getX(), ov.getY(), ov.getZ() };
+    double d[3] = { dv.getX(), dv.getY(), dv.getZ() };
+    double inv[3];
+    for (int a = 0; a < 3; a++) inv[a] = 1. / d[a];
+    bool found = false;
+    double best = tmax;
+    size_t stack[2 * BVH_DEPTH + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const bvhNode &node = m_nodes[stack[--top]];
+        if (!box(node, o, inv, best)) continue;
+        if (node.count > 0) {
+            for (size_t k = node.first; k < node.first + node.count; k++) {
+                size_t f = m_index[k];
+                double th;
+                if ((f != skip) && hit(f, o, d, best, th)) {
+                    best = th;
+                    facet = f;
+                    found = true;
+                }
+            }
+            continue;
+        }
+        stack[top++] = node.right;
+        stack[top++] = &node - &m_nodes[0] + 1;
+    }
+    if (found) t = best;
+    return found;
+}
@@ -0,0 +1,48 @@
+#ifndef BVH_H
+#define BVH_H
+#include "Calc_Radar/Triangle.h"
+#include <vector>
+
+/*
+Иерархия ограничивающих параллелепипедов (BVH) по треугольникам модели для
+трассировки лучей: затенение треугольников (occluded) и ближайшее пересечение
+(intersect). узел делится по середине наибольшей стороны параллелепипеда
+центров, в листе не больше BVH_LEAF треугольников. пересечение с треугольником -
+алгоритм Моллера - Трумбора. пакет лучей с общим направлением обходит дерево
+один раз: узел посещается, если в него попадает хотя бы один активный луч.
+дерево не меняется после построения, запросы выполняются из любых потоков
+*/
+
+class facetBvh
+{
+public:
+    //построение по всем треугольникам (освещенность не учитывается)
+    void build(std::vector<triangle> &triangles);
+    bool empty() const { return m_nodes.empty(); }
+    size_t size() const { return m_index.size(); }
+
+    //луч origin + t*dir, 0 < t < tmax, пересекает треугольник, отличный от skip
+    bool occluded(const rVect &origin, const rVect &dir, double tmax, size_t skip) const;
+    //пакет из count <= 32 лучей с общим направлением: бит i - луч i затенен
+    unsigned occludedPacket(const rVect *origin, int count, const rVect &dir,
+                            const double *tmax, size_t skip) const;
+    //ближайшее пересечение: true - найдено, t - расстояние, facet - номер треугольника
+    bool intersect(const rVect &origin, const rVect &dir, double tmax, size_t skip,
+                   double &t, size_t &facet) const;
+
+private:
+    struct bvhNode {
+        double lo[3], hi[3];   //границы
+        size_t first, count;   //лист: треугольники m_index[first, first + count)
+        size_t right;          //внутренний узел: левый потомок - следующий, правый - right
+    };
+    std::vector<bvhNode> m_nodes;
+    std::vector<size_t> m_index;  //номера треугольников в порядке листьев
+    std::vector<double> m_vert;   //вершины: по 9 чисел на треугольник (по номеру в модели)
+
+    size_t split(std::vector<double> &centres, size_t first, size_t count, int depth);
+    bool hit(size_t facet, const double *o, const double *d, double tmax, double &t) const;
+    static bool box(const bvhNode &node, const double *o, const double *inv, double tmax);
+};
+
+#endif // BVH_H
@@ -0,0 +1,304 @@
+#include "Calc_Radar/mesh_decimation.h"
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <unordered_map>
+
+//число упрощенных моделей, хранимых в памяти
+static const size_t DECIMATION_CACHE = 8;
+//косинус наибольшего поворота нормали треугольника при стягивании ребра
+static const double FLIP_COS = 0.5;
+
+QMutex meshDecimation::m_mutex;
+std::vector<std::pair<QString, std::shared_ptr<decimatedMesh>>> meshDecimation::m_cache;
+
+
+//квадратичная форма суммы квадратов расстояний до плоскостей n·r + d = 0
+struct quadric
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    quadric(): a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0) {}
+
+    void addPlane(rVect n, double d)
+    {
+        double a = n.getX(), b = n.getY(), c = n.getZ();
+        a2 += a * a; ab += a * b; ac += a * c; ad += a * d;
+        b2 += b * b; bc += b * c; bd += b * d;
+        c2 += c * c; cd += c * d; d2 += d * d;
+    }
+    void add(const quadric &q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd; d2 += q.d2;
+    }
+    double error(rVect p) const
+    {
+        double x = p.getX(), y = p.getY(), z = p.getZ();
+        return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+               b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+               c2 * z * z + 2 * cd * z + d2;
+    }
+    //точка наименьшей ошибки; false - форма вырождена (плоский или цилиндрический участок)
+    bool optimum(rVect &p) const
+    {
+        double det = a2 * (b2 * c2 - bc * bc) - ab * (ab * c2 - bc * ac) + ac * (ab * bc - b2 * ac);
+        double tr = a2 + b2 + c2;
+        if (fabs(det) <= 1e-9 * tr * tr * tr) return false;
+        double x = -(ad * (b2 * c2 - bc * bc) - ab * (bd * c2 - bc * cd) + ac * (bd * bc - b2 * cd)) / det;
+        double y = -(a2 * (bd * c2 - cd * bc) - ad * (ab * c2 - bc * ac) + ac * (ab * cd - bd * ac)) / det;
+        double z = -(a2 * (b2 * cd - bc * bd) - ab * (ab * cd - bd * ac) + ad * (ab * bc - b2 * ac)) / det;
+        p.setPoint(x, y, z);
+        return true;
+    }
+};
+
+
+namespace {
+
+//модель для упрощения: вершины, треугольники по номерам вершин
+struct decimator
+{
+    vector<rVect> pos;
+    vector<quadric> quad;
+    vector<int> stamp;              //номер изменения вершины (устаревшие ребра в очереди)
+    vector<char> dead;              //вершина стянута
+    vector<vector<size_t>> around;  //треугольники вершины (в том числе удаленные)
+    vector<int> tri;                //по три вершины на треугольник
+    vector<char> visible;
+    vector<char> removed;
+
+    struct collapse {
+        double cost;
+        int u, v, su, sv;
+        rVect p;
+        bool operator<(const collapse &c) const { return cost > c.cost; }
+    };
+    std::priority_queue<collapse> heap;
+    double limit;
+
+    rVect normal(size_t t, int from, int to, rVect p)
+    {
+        rVect r[3];
+        for (int k = 0; k < 3; k++)
+            r[k] = (tri[3 * t + k] == from) || (tri[3 * t + k] == to) ? p : pos[tri[3 * t + k]];
+        return (r[1] - r[0]) ^ (r[2] - r[0]);
+    }
+    bool contains(size_t t, int v)
+    {
+        return (tri[3 * t] == v) || (tri[3 * t + 1] == v) || (tri[3 * t + 2] == v);
+    }
+    //соседи вершины по живым треугольникам
+    vector<int> neighbours(int v)
+    {
+        vector<int> n;
+        for (size_t t : around[v]) {
+            if (removed[t]) continue;
+            for (int k = 0; k < 3; k++)
+                if (tri[3 * t + k] != v) n.push_back(tri[3 * t + k]);
+        }
+        std::sort(n.begin(), n.end());
+        n.erase(std::unique(n.begin(), n.end()), n.end());
+        return n;
+    }
+    //оценка стягивания ребра (u, v) в очередь, если ошибка в пределах допуска
+    void push(int u, int v)
+    {
+        quadric q = quad[u];
+        q.add(quad[v]);
+        collapse c;
+        c.u = u; c.v = v; c.su = stamp[u]; c.sv = stamp[v];
+        rVect best, mid = 0.5 * (pos[u] + pos[v]);
+        //точка наименьшей ошибки берется только вблизи ребра
+        if (!q.optimum(best) || ((best - mid).length() > (pos[u] - pos[v]).length()) ||
+            (q.error(best) > limit)) {
+            rVect cand[3] = { pos[u], pos[v], mid };
+            best = cand[0];
+            for (int k = 1; k < 3; k++)
+                if (q.error(cand[k]) < q.error(best)) best = cand[k];
+        }
+        c.p = best;
+        c.cost = std::max(0., q.error(best));
+        if (c.cost <= limit) heap.push(c);
+    }
+    //стягивание ребра; false - стягивание недопустимо
+    bool apply(const collapse &c)
+    {
+        int u = c.u, v = c.v;
+        int shared = 0;
+        char vis = -1;
+        for (int w : { u, v })
+            for (size_t t : around[w]) {
+                if (removed[t]) continue;
+                if (vis < 0) vis = visible[t];
+                if (visible[t] != vis) return false;
+                if ((w == u) && contains(t, v)) shared++;
+            }
+        //условие звена: общие соседи - только вершины общих треугольников
+        vector<int> nu = neighbours(u), nv = neighbours(v), common;
+        std::set_intersection(nu.begin(), nu.end(), nv.begin(), nv.end(), std::back_inserter(common));
+        if ((int)common.size() != shared) return false;
+        //треугольники не выворачиваются и не вырождаются
+        for (int w : { u, v })
+            for (size_t t : around[w]) {
+                if (removed[t] || (contains(t, u) && contains(t, v))) continue;
+                rVect n0 = normal(t, -1, -1, rVect());
+                rVect n1 = normal(t, u, v, c.p);
+                if (n1 * n0 <= FLIP_COS * n0.length() * n1.length()) return false;
+            }
+        for (size_t t : around[v]) {
+            if (removed[t]) continue;
+            if (contains(t, u)) {
+                removed[t] = 1;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+                if (tri[3 * t + k] == v) tri[3 * t + k] = u;
+            around[u].push_back(t);
+        }
+        around[v].clear();
+        dead[v] = 1;
+        pos[u] = c.p;
+        quad[u].add(quad[v]);
+        stamp[u]++;
+        stamp[v]++;
+        for (int w : neighbours(u)) push(u, w);
+        return true;
+    }
+};
+
+} // namespace
+
+
+std::shared_ptr<decimatedMesh> meshDecimation::decimate(std::vector<triangle> &source, double tolerance)
+{
+    decimator d;
+    d.limit = tolerance * tolerance;
+    std::unordered_map<node *, int> index;
+    for (triangle &tr : source) {
+        node *v[3] = { tr.getV1(), tr.getV2(), tr.getV3() };
+        for (int k = 0; k < 3; k++) {
+            auto it = index.find(v[k]);
+            if (it == index.end()) {
+                it = index.insert(std::make_pair(v[k], (int)d.pos.size())).first;
+                d.pos.push_back(*v[k]);
+            }
+            d.tri.push_back(it->second);
+        }
+        d.visible.push_back(tr.getVisible());
+    }
+    size_t size = source.size();
+    size_t vertices = d.pos.size();
+    d.quad.resize(vertices);
+    d.stamp.assign(vertices, 0);
+    d.dead.assign(vertices, 0);
+    d.around.resize(vertices);
+    d.removed.assign(size, 0);
+
+    //плоскости треугольников и треугольники ребер
+    std::map<std::pair<int, int>, vector<size_t>> edges;
+    vector<rVect> normals(size);
+    for (size_t t = 0; t < size; t++) {
+        int *v = &d.tri[3 * t];
+        rVect n = d.normal(t, -1, -1, rVect());
+        double len = n.length();
+        if (len == 0.) {
+            d.removed[t] = 1; //вырожденный треугольник в расчет не входит
+            continue;
+        }
+        normals[t] = 1. / len * n;
+        double dist = -(normals[t] * d.pos[v[0]]);
+        for (int k = 0; k < 3; k++) {
+            d.quad[v[k]].addPlane(normals[t], dist);
+            d.around[v[k]].push_back(t);
+            int a = v[k], b = v[(k + 1) % 3];
+            edges[std::make_pair(std::min(a, b), std::max(a, b))].push_back(t);
+        }
+    }
+    //края модели и границы освещенности закрепляются плоскостями через ребро
+    for (auto &e : edges) {
+        vector<size_t> &ts = e.second;
+        bool border = (ts.size() != 2) || (d.visible[ts[0]] != d.visible[ts[1]]);
+        if (!border) continue;
+        rVect a = d.pos[e.first.first], b = d.pos[e.first.second];
+        for (size_t t : ts) {
+            rVect m = (b - a) ^ normals[t];
+            double len = m.length();
+            if (len == 0.) continue;
+            m = 1. / len * m;
+            d.quad[e.first.first].addPlane(m, -(m * a));
+            d.quad[e.first.second].addPlane(m, -(m * a));
+        }
+    }
+    for (auto &e : edges) d.push(e.first.first, e.first.second);
+
+    while (!d.heap.empty()) {
+        decimator::collapse c = d.heap.top();
+        d.heap.pop();
+        if (d.dead[c.u] || d.dead[c.v] || (c.su != d.stamp[c.u]) || (c.sv != d.stamp[c.v])) continue;
+        d.apply(c);
+    }
+
+    //упрощенная модель: живые вершины и треугольники
+    std::shared_ptr<decimatedMesh> mesh = std::make_shared<decimatedMesh>();
+    mesh->source = size;
+    vector<int> renum(vertices, -1);
+    for (size_t v = 0; v < vertices; v++) {
+        if (d.dead[v] || d.around[v].empty()) continue;
+        renum[v] = mesh->nodes.size();
+        mesh->nodes.push_back(node(d.pos[v].getX(), d.pos[v].getY(), d.pos[v].getZ(), true));
+    }
+    for (size_t t = 0; t < size; t++) {
+        if (d.removed[t]) continue;
+        int *v = &d.tri[3 * t];
+        mesh->triangles.push_back(triangle(d.visible[t], &mesh->nodes[renum[v[0]]],
+                                           &mesh->nodes[renum[v[1]]], &mesh->nodes[renum[v[2]]]));
+    }
+    mesh->bvh.build(mesh->triangles);
+    return mesh;
+}
+
+
+QString meshDecimation::modelKey(std::vector<triangle> &source)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (triangle &tr : source) {
+        node *v[3] = { tr.getV1(), tr.getV2(), tr.getV3() };
+        double data[10];
+        for (int k = 0; k < 3; k++) {
+            data[3 * k] = v[k]->getX();
+            data[3 * k + 1] = v[k]->getY();
+            data[3 * k + 2] = v[k]->getZ();
+        }
+        data[9] = tr.getVisible() ? 1. : 0.;
+        hash.addData((const char *)data, sizeof(data));
+    }
+    return QString(hash.result().toHex());
+}
+
+
+std::shared_ptr<decimatedMesh> meshDecimation::get(const QString &key, std::vector<triangle> &source,
+                                                   double tolerance, bool &cached)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        for (size_t i = 0; i < m_cache.size(); i++)
+            if (m_cache[i].first == key) {
+                std::pair<QString, std::shared_ptr<decimatedMesh>> entry = m_cache[i];
+                m_cache.erase(m_cache.begin() + i);
+                m_cache.push_back(entry);
+                cached = true;
+                return entry.second;
+            }
+    }
+    //упрощение - вне блокировки: другие задачи в это время берут свои модели
+    std::shared_ptr<decimatedMesh> mesh = decimate(source, tolerance);
+    QMutexLocker locker(&m_mutex);
+    m_cache.push_back(std::make_pair(key, mesh));
+    if (m_cache.size() > DECIMATION_CACHE) m_cache.erase(m_cache.begin());
+    cached = false;
+    return mesh;
+}
@@ -0,0 +1,50 @@
+#ifndef MESH_DECIMATION_H
+#define MESH_DECIMATION_H
+#include "Calc_Radar/Triangle.h"
+#include "Calc_Radar/bvh.h"
+#include <QMutex>
+#include <QString>
+#include <memory>
+#include <vector>
+
+/*
+Упрощение модели перед расчетом (Garland, Heckbert): ребра стягиваются в
+порядке возрастания квадратичной ошибки - суммы квадратов расстояний от
+новой вершины до плоскостей исходных треугольников, примыкавших к стянутым
+вершинам. ошибка не больше tolerance^2 (tolerance - доля длины волны), поэтому
+изогнутые участки и острые кромки сохраняются, а плоские и слабо изогнутые
+упрощаются. края модели и границы освещенности закреплены дополнительными
+плоскостями через ребро перпендикулярно треугольнику; ребро не стягивается,
+если у его вершин треугольники с разной освещенностью, если нарушается
+топология (условие звена) или если нормаль треугольника поворачивается
+больше чем на 60 градусов.
+Результат для пары (модель, диапазон) хранится в памяти: узлы упрощенной
+модели общие для всех задач и ядер, которые его используют, и не меняются.
+*/
+
+struct decimatedMesh
+{
+    std::vector<node> nodes;          //узлы упрощенной модели
+    std::vector<triangle> triangles;  //треугольники с вершинами в nodes
+    size_t source;                    //число исходных треугольников
+    facetBvh bvh;                     //BVH треугольников (затенение, SBR)
+};
+
+class meshDecimation
+{
+public:
+    //упрощенная модель по ключу key (модель, диапазон, допуск); при отсутствии
+    //в памяти строится по source; cached - результат взят из памяти
+    static std::shared_ptr<decimatedMesh> get(const QString &key, std::vector<triangle> &source,
+                                              double tolerance, bool &cached);
+    //упрощение модели с допуском tolerance (м)
+    static std::shared_ptr<decimatedMesh> decimate(std::vector<triangle> &source, double tolerance);
+    //хеш геометрии и освещенности модели
+    static QString modelKey(std::vector<triangle> &source);
+
+private:
+    static QMutex m_mutex;
+    static std::vector<std::pair<QString, std::shared_ptr<decimatedMesh>>> m_cache; //последние - в конце
+};
+
+#endif // MESH_DECIMATION_H
@@ -58,7 +58,7 @@ public:
 }; //end class
 
 
-rMatrix transpon(rMatrix matr)
+inline rMatrix transpon(rMatrix matr)
 {
 	size_t col, row;
 	rMatrix res;
@@ -0,0 +1,80 @@
+#include "Calc_Radar/sbr.h"
+#include <limits>
+
+
+int sbrTracer::trace(rVect origin, rVect dir, rVect a, rVect b, rVect E, rVect E2,
+                     int bounces, std::vector<sbrExit> &exits) const
+{
+    //до первого отражения фаза отсчитывается от плоскости через начало координат
+    double path = dir * origin;
+    size_t skip = (size_t)-1;
+    int bounce = 0;
+    while (bounce < bounces) {
+        double t;
+        size_t facet;
+        if (!m_bvh.intersect(origin, dir, std::numeric_limits<double>::max(), skip, t, facet)) break;
+        bounce++;
+        rVect r = origin + t * dir;
+        path += t;
+        rVect n = m_normals[facet];
+        double nd = n * dir;
+        if (nd > 0.) {
+            n = -1. * n;
+            nd = -nd;
+        }
+        if (nd == 0.) break; //скользящее падение: трубка не отражается
+        if (bounce >= 2) {
+            sbrExit e;
+            e.r = r;
+            e.d = dir;
+            e.n = n;
+            e.a = a - ((n * a) / nd) * dir;
+            e.b = b - ((n * b) / nd) * dir;
+            e.E = E;
+            e.E2 = E2;
+            e.path = path;
+            e.bounce = bounce;
+            exits.push_back(e);
+        }
+        dir = dir - (2 * nd) * n;
+        a = a - (2 * (n * a)) * n;
+        b = b - (2 * (n * b)) * n;
+        E = (2 * (n * E)) * n - E;
+        E2 = (2 * (n * E2)) * n - E2;
+        origin = r;
+        skip = facet;
+    }
+    return bounce;
+}
+
+
+void sbrTracer::sweep(const sbrExit &e, rVect Nout, double w0, double dW, int n, complex<double> *res)
+{
+    const int RESEED = 64;
+    rVect q = e.d - Nout;
+    rVect a = e.a, b = e.b;
+    double area = (a ^ b).length() / (2 * Pi);
+    double p = e.path - Nout * e.r, sa = 0.5 * (q * a), sb = 0.5 * (q * b);
+    complex<double> ep, ea, eb;
+    complex<double> sp = exp(-OneI * dW * p), ssa = exp(-OneI * dW * sa), ssb = exp(-OneI * dW * sb);
+    for (int j = 0; j < n; j++) {
+        double wave = w0 - j * dW;
+        if (j % RESEED == 0) {
+            ep = exp(OneI * wave * p);
+            ea = exp(OneI * wave * sa);
+            eb = exp(OneI * wave * sb);
+        }
+        double xa = wave * sa, xb = wave * sb;
+        double sinca = (fabs(xa) < 1e-4) ? 1. - xa * xa / 6. : ea.imag() / xa;
+        double sincb = (fabs(xb) < 1e-4) ? 1. - xb * xb / 6. : eb.imag() / xb;
+        res[j] = (wave * area * sinca * sincb) * ep;
+        ep *= sp; ea *= ssa; eb *= ssb;
+    }
+}
+
+
+rVect sbrTracer::polarization(const sbrExit &e, rVect Nout, rVect E)
+{
+    rVect J = -1. * (e.n ^ (e.d ^ E));
+    return J - (J * Nout) * Nout;
+}
@@ -0,0 +1,56 @@
+#ifndef SBR_H
+#define SBR_H
+#include "Calc_Radar/bvh.h"
+#include <vector>
+
+/*
+Метод бросания и отражения лучей (SBR) для многократных отражений. лучевые
+трубки сечением delta x delta запускаются вдоль Nin и отражаются от
+треугольников модели как от идеального проводника:
+    d' = d - 2(n·d)n,  E' = 2(n·E)n - E,
+сечение трубки (векторы a, b) отражается так же, как направление. в точке
+каждого отражения, начиная со второго (первое учитывается ФО по освещенным
+треугольникам), запоминается выход трубки: вклад тока ФО, наведенного
+полем трубки на ее след на поверхности - параллелограмм a_s x b_s
+(a, b, спроецированные на плоскость треугольника вдоль d):
+    E(w, Nout) = w/(2Pi) * |a_s ^ b_s| * exp(i*w*(L - Nout·r)) *
+                 sinc(w*q·a_s/2) * sinc(w*q·b_s/2) * P(n, Nout, E),
+q = d - Nout, L - фазовый путь (Nin·r1 до первого отражения плюс длины
+отрезков), P - поперечная к Nout часть тока n ^ (Nout ^ E) для обратного
+направления Nout = -d (как в triangle::CulcPolarization), то есть по
+направлению трубки: P = J - (J·Nout)Nout, J = -n ^ (d ^ E).
+трубки не расходятся (грани плоские), поэтому сечение не меняется
+*/
+
+struct sbrExit
+{
+    rVect r;        //точка отражения
+    rVect d;        //направление падения трубки
+    rVect n;        //нормаль со стороны падения
+    rVect a, b;     //след трубки на поверхности
+    rVect E, E2;    //поле трубки (для двух поляризаций падающей волны)
+    double path;    //фазовый путь
+    int bounce;     //номер отражения
+};
+
+class sbrTracer
+{
+public:
+    //bvh и нормали треугольников модели (единичные)
+    sbrTracer(const facetBvh &bvh, const std::vector<rVect> &normals): m_bvh(bvh), m_normals(normals) {}
+
+    //трубка из origin вдоль dir (|dir| = 1), сечение a x b, поле E (E2);
+    //выходы отражений 2..bounces добавляются в exits. возвращает число отражений
+    int trace(rVect origin, rVect dir, rVect a, rVect b, rVect E, rVect E2,
+              int bounces, std::vector<sbrExit> &exits) const;
+    //вклад выхода без поляризационного множителя на сетке волновых чисел w0 - j*dW
+    static void sweep(const sbrExit &e, rVect Nout, double w0, double dW, int n, complex<double> *res);
+    //поляризационный множитель выхода для поля трубки E
+    static rVect polarization(const sbrExit &e, rVect Nout, rVect E);
+
+private:
+    const facetBvh &m_bvh;
+    const std::vector<rVect> &m_normals;
+};
+
+#endif // SBR_H
@@ -0,0 +1,579 @@
+#include "Calc_Radar/solver_kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#else
+#define KERNEL_X86 0
+#endif
+
+//период пересчета фазовых экспонент в векторных ядрах (как в DifractionSweep)
+static const int RESEED = 64;
+//точность вычисления вещественных чисел (как в Difraction)
+static const double DELTA = 5.e-3;
+
+
+//эталон: дифракционный интеграл заново в каждой точке
+static void sweepReference(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                           complex<double> *res)
+{
+    for (int j = 0; j < n; j++)
+        res[j] = tr.Difraction(Nin, Nout, w0 - j * dW);
+}
+
+
+//рекуррентные фазовые экспоненты
+static void sweepScalar(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                        complex<double> *res)
+{
+    tr.DifractionSweep(Nin, Nout, w0, dW, n, res);
+}
+
+
+//одинарная точность: постоянные треугольника и фазовые экспоненты во float,
+//начальные экспоненты отрезка и результат - в double. разность фаз a-b
+//считается по разности проекций в double, иначе при a ~ b теряются разряды
+static void sweepFloat(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                       complex<double> *res)
+{
+    rVect V1 = *tr.getV1();
+    rVect v2 = *tr.getV2() - V1;
+    rVect v3 = *tr.getV3() - V1;
+    rVect q = Nin - Nout;
+    double qa = q * v3, qb = q * v2, q1 = q * V1;
+    double c = (v2 ^ v3).length();
+    float fqa = qa, fqb = qb, fqd = qa - qb, fk = c / (2 * Pi);
+    complex<float> sa(exp(-OneI * (dW * qa))), sb(exp(-OneI * (dW * qb))), s1(exp(-OneI * (dW * q1)));
+    complex<float> ea, eb, e1;
+    for (int j = 0; j < n; j++)
+    {
+        double wd = w0 - j * dW;
+        if (j % RESEED == 0) {
+            ea = complex<float>(exp(OneI * (wd * qa)));
+            eb = complex<float>(exp(OneI * (wd * qb)));
+            e1 = complex<float>(exp(OneI * (wd * q1)));
+        }
+        float w = wd;
+        float a = w * fqa, b = w * fqb, d = w * fqd;
+        if ((fabsf(a) <= DELTA) || (fabsf(b) <= DELTA) || (fabsf(d) <= DELTA))
+            res[j] = triangle::Integral(a, b, c, wd / (2 * Pi) * complex<double>(e1),
+                                        complex<double>(ea), complex<double>(eb));
+        else
+            res[j] = complex<double>(w * fk / (a * b) * e1 * ((a * eb - b * ea) / d - 1.f));
+        ea *= sa; eb *= sb; e1 *= s1;
+    }
+}
+
+
+#if KERNEL_X86
+//векторные ядра: в регистре L соседних частот, экспоненты соседних регистров
+//отличаются множителем exp(-i*L*dW*q). вырожденные случаи интеграла (малые
+//фазы) редки, регистр с ними досчитывается по скалярным формулам
+TARGET_AVX2
+static void sweepAvx2(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                      complex<double> *res)
+{
+    const int L = 4;
+    rVect V1 = *tr.getV1();
+    rVect v2 = *tr.getV2() - V1;
+    rVect v3 = *tr.getV3() - V1;
+    rVect q = Nin - Nout;
+    double qa = q * v3, qb = q * v2, q1 = q * V1;
+    double c = (v2 ^ v3).length();
+    complex<double> sa = exp(-OneI * (L * dW * qa));
+    complex<double> sb = exp(-OneI * (L * dW * qb));
+    complex<double> s1 = exp(-OneI * (L * dW * q1));
+    const __m256d sar = _mm256_set1_pd(sa.real()), sai = _mm256_set1_pd(sa.imag());
+    const __m256d sbr = _mm256_set1_pd(sb.real()), sbi = _mm256_set1_pd(sb.imag());
+    const __m256d s1r = _mm256_set1_pd(s1.real()), s1i = _mm256_set1_pd(s1.imag());
+    const __m256d lane = _mm256_setr_pd(0., dW, 2. * dW, 3. * dW);
+    const __m256d sign = _mm256_set1_pd(-0.), delta = _mm256_set1_pd(DELTA), one = _mm256_set1_pd(1.);
+    const __m256d vqa = _mm256_set1_pd(qa), vqb = _mm256_set1_pd(qb);
+    const __m256d k0 = _mm256_set1_pd(c / (2 * Pi));
+    alignas(32) double t0[L], t1[L], t2[L], t3[L], t4[L], t5[L];
+
+    int j = 0;
+    for (; j + L <= n; )
+    {
+        //пересчет экспонент в начале каждого отрезка из RESEED частот
+        for (int l = 0; l < L; l++) {
+            double w = w0 - (j + l) * dW;
+            complex<double> ea = exp(OneI * (w * qa)), eb = exp(OneI * (w * qb)), e1 = exp(OneI * (w * q1));
+            t0[l] = ea.real(); t1[l] = ea.imag();
+            t2[l] = eb.real(); t3[l] = eb.imag();
+            t4[l] = e1.real(); t5[l] = e1.imag();
+        }
+        __m256d ear = _mm256_load_pd(t0), eai = _mm256_load_pd(t1);
+        __m256d ebr = _mm256_load_pd(t2), ebi = _mm256_load_pd(t3);
+        __m256d e1r = _mm256_load_pd(t4), e1i = _mm256_load_pd(t5);
+        int end = std::min(n, j + RESEED);
+        for (; j + L <= end; j += L)
+        {
+            __m256d w = _mm256_sub_pd(_mm256_set1_pd(w0 - j * dW), lane);
+            __m256d a = _mm256_mul_pd(w, vqa);
+            __m256d b = _mm256_mul_pd(w, vqb);
+            __m256d d = _mm256_sub_pd(a, b);
+            __m256d small = _mm256_or_pd(
+                _mm256_or_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign, a), delta, _CMP_LE_OQ),
+                             _mm256_cmp_pd(_mm256_andnot_pd(sign, b), delta, _CMP_LE_OQ)),
+                _mm256_cmp_pd(_mm256_andnot_pd(sign, d), delta, _CMP_LE_OQ));
+            if (_mm256_movemask_pd(small)) {
+                alignas(32) double ta[L], tb[L];
+                _mm256_store_pd(ta, a); _mm256_store_pd(tb, b);
+                _mm256_store_pd(t0, ear); _mm256_store_pd(t1, eai);
+                _mm256_store_pd(t2, ebr); _mm256_store_pd(t3, ebi);
+                _mm256_store_pd(t4, e1r); _mm256_store_pd(t5, e1i);
+                for (int l = 0; l < L; l++) {
+                    double wl = w0 - (j + l) * dW;
+                    res[j + l] = triangle::Integral(ta[l], tb[l], c, wl / (2 * Pi) * complex<double>(t4[l], t5[l]),
+                                                    complex<double>(t0[l], t1[l]), complex<double>(t2[l], t3[l]));
+                }
+            }
+            else {
+                //phase*c/(a*b)*((a*eb-b*ea)/(a-b)-1)
+                __m256d nr = _mm256_sub_pd(_mm256_mul_pd(a, ebr), _mm256_mul_pd(b, ear));
+                __m256d ni = _mm256_sub_pd(_mm256_mul_pd(a, ebi), _mm256_mul_pd(b, eai));
+                __m256d tr_ = _mm256_sub_pd(_mm256_div_pd(nr, d), one);
+                __m256d ti = _mm256_div_pd(ni, d);
+                __m256d k = _mm256_div_pd(_mm256_mul_pd(w, k0), _mm256_mul_pd(a, b));
+                __m256d rr = _mm256_mul_pd(k, _mm256_sub_pd(_mm256_mul_pd(e1r, tr_), _mm256_mul_pd(e1i, ti)));
+                __m256d ri = _mm256_mul_pd(k, _mm256_add_pd(_mm256_mul_pd(e1r, ti), _mm256_mul_pd(e1i, tr_)));
+                _mm256_store_pd(t0, rr); _mm256_store_pd(t1, ri);
+                for (int l = 0; l < L; l++)
+                    res[j + l] = complex<double>(t0[l], t1[l]);
+            }
+            //переход к следующим L частотам
+            __m256d r;
+            r = _mm256_sub_pd(_mm256_mul_pd(ear, sar), _mm256_mul_pd(eai, sai));
+            eai = _mm256_add_pd(_mm256_mul_pd(ear, sai), _mm256_mul_pd(eai, sar)); ear = r;
+            r = _mm256_sub_pd(_mm256_mul_pd(ebr, sbr), _mm256_mul_pd(ebi, sbi));
+            ebi = _mm256_add_pd(_mm256_mul_pd(ebr, sbi), _mm256_mul_pd(ebi, sbr)); ebr = r;
+            r = _mm256_sub_pd(_mm256_mul_pd(e1r, s1r), _mm256_mul_pd(e1i, s1i));
+            e1i = _mm256_add_pd(_mm256_mul_pd(e1r, s1i), _mm256_mul_pd(e1i, s1r)); e1r = r;
+        }
+    }
+    //остаток меньше регистра
+    for (; j < n; j++)
+        res[j] = tr.Difraction(Nin, Nout, w0 - j * dW);
+}
+
+
+TARGET_AVX512
+static void sweepAvx512(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                        complex<double> *res)
+{
+    const int L = 8;
+    rVect V1 = *tr.getV1();
+    rVect v2 = *tr.getV2() - V1;
+    rVect v3 = *tr.getV3() - V1;
+    rVect q = Nin - Nout;
+    double qa = q * v3, qb = q * v2, q1 = q * V1;
+    double c = (v2 ^ v3).length();
+    complex<double> sa = exp(-OneI * (L * dW * qa));
+    complex<double> sb = exp(-OneI * (L * dW * qb));
+    complex<double> s1 = exp(-OneI * (L * dW * q1));
+    const __m512d sar = _mm512_set1_pd(sa.real()), sai = _mm512_set1_pd(sa.imag());
+    const __m512d sbr = _mm512_set1_pd(sb.real()), sbi = _mm512_set1_pd(sb.imag());
+    const __m512d s1r = _mm512_set1_pd(s1.real()), s1i = _mm512_set1_pd(s1.imag());
+    const __m512d lane = _mm512_setr_pd(0., dW, 2. * dW, 3. * dW, 4. * dW, 5. * dW, 6. * dW, 7. * dW);
+    const __m512d delta = _mm512_set1_pd(DELTA), one = _mm512_set1_pd(1.);
+    const __m512d vqa = _mm512_set1_pd(qa), vqb = _mm512_set1_pd(qb);
+    const __m512d k0 = _mm512_set1_pd(c / (2 * Pi));
+    alignas(64) double t0[L], t1[L], t2[L], t3[L], t4[L], t5[L];
+
+    int j = 0;
+    for (; j + L <= n; )
+    {
+        for (int l = 0; l < L; l++) {
+            double w = w0 - (j + l) * dW;
+            complex<double> ea = exp(OneI * (w * qa)), eb = exp(OneI * (w * qb)), e1 = exp(OneI * (w * q1));
+            t0[l] = ea.real(); t1[l] = ea.imag();
+            t2[l] = eb.real(); t3[l] = eb.imag();
+            t4[l] = e1.real(); t5[l] = e1.imag();
+        }
+        __m512d ear = _mm512_load_pd(t0), eai = _mm512_load_pd(t1);
+        __m512d ebr = _mm512_load_pd(t2), ebi = _mm512_load_pd(t3);
+        __m512d e1r = _mm512_load_pd(t4), e1i = _mm512_load_pd(t5);
+        int end = std::min(n, j + RESEED);
+        for (; j + L <= end; j += L)
+        {
+            __m512d w = _mm512_sub_pd(_mm512_set1_pd(w0 - j * dW), lane);
+            __m512d a = _mm512_mul_pd(w, vqa);
+            __m512d b = _mm512_mul_pd(w, vqb);
+            __m512d d = _mm512_sub_pd(a, b);
+            __mmask8 small = _mm512_cmp_pd_mask(_mm512_abs_pd(a), delta, _CMP_LE_OQ) |
+                             _mm512_cmp_pd_mask(_mm512_abs_pd(b), delta, _CMP_LE_OQ) |
+                             _mm512_cmp_pd_mask(_mm512_abs_pd(d), delta, _CMP_LE_OQ);
+            if (small) {
+                alignas(64) double ta[L], tb[L];
+                _mm512_store_pd(ta, a); _mm512_store_pd(tb, b);
+                _mm512_store_pd(t0, ear); _mm512_store_pd(t1, eai);
+                _mm512_store_pd(t2, ebr); _mm512_store_pd(t3, ebi);
+                _mm512_store_pd(t4, e1r); _mm512_store_pd(t5, e1i);
+                for (int l = 0; l < L; l++) {
+                    double wl = w0 - (j + l) * dW;
+                    res[j + l] = triangle::Integral(ta[l], tb[l], c, wl / (2 * Pi) * complex<double>(t4[l], t5[l]),
+                                                    complex<double>(t0[l], t1[l]), complex<double>(t2[l], t3[l]));
+                }
+            }
+            else {
+                __m512d nr = _mm512_sub_pd(_mm512_mul_pd(a, ebr), _mm512_mul_pd(b, ear));
+                __m512d ni = _mm512_sub_pd(_mm512_mul_pd(a, ebi), _mm512_mul_pd(b, eai));
+                __m512d tr_ = _mm512_sub_pd(_mm512_div_pd(nr, d), one);
+                __m512d ti = _mm512_div_pd(ni, d);
+                __m512d k = _mm512_div_pd(_mm512_mul_pd(w, k0), _mm512_mul_pd(a, b));
+                __m512d rr = _mm512_mul_pd(k, _mm512_sub_pd(_mm512_mul_pd(e1r, tr_), _mm512_mul_pd(e1i, ti)));
+                __m512d ri = _mm512_mul_pd(k, _mm512_add_pd(_mm512_mul_pd(e1r, ti), _mm512_mul_pd(e1i, tr_)));
+                _mm512_store_pd(t0, rr); _mm512_store_pd(t1, ri);
+                for (int l = 0; l < L; l++)
+                    res[j + l] = complex<double>(t0[l], t1[l]);
+            }
+            __m512d r;
+            r = _mm512_sub_pd(_mm512_mul_pd(ear, sar), _mm512_mul_pd(eai, sai));
+            eai = _mm512_add_pd(_mm512_mul_pd(ear, sai), _mm512_mul_pd(eai, sar)); ear = r;
+            r = _mm512_sub_pd(_mm512_mul_pd(ebr, sbr), _mm512_mul_pd(ebi, sbi));
+            ebi = _mm512_add_pd(_mm512_mul_pd(ebr, sbi), _mm512_mul_pd(ebi, sbr)); ebr = r;
+            r = _mm512_sub_pd(_mm512_mul_pd(e1r, s1r), _mm512_mul_pd(e1i, s1i));
+            e1i = _mm512_add_pd(_mm512_mul_pd(e1r, s1i), _mm512_mul_pd(e1i, s1r)); e1r = r;
+        }
+    }
+    for (; j < n; j++)
+        res[j] = tr.Difraction(Nin, Nout, w0 - j * dW);
+}
+
+
+//векторные ядра одинарной точности: вдвое больше частот в регистре
+TARGET_AVX2
+static void sweepAvx2Float(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                           complex<double> *res)
+{
+    const int L = 8;
+    rVect V1 = *tr.getV1();
+    rVect v2 = *tr.getV2() - V1;
+    rVect v3 = *tr.getV3() - V1;
+    rVect q = Nin - Nout;
+    double qa = q * v3, qb = q * v2, q1 = q * V1;
+    double c = (v2 ^ v3).length();
+    complex<double> sa = exp(-OneI * (L * dW * qa));
+    complex<double> sb = exp(-OneI * (L * dW * qb));
+    complex<double> s1 = exp(-OneI * (L * dW * q1));
+    const __m256 sar = _mm256_set1_ps(sa.real()), sai = _mm256_set1_ps(sa.imag());
+    const __m256 sbr = _mm256_set1_ps(sb.real()), sbi = _mm256_set1_ps(sb.imag());
+    const __m256 s1r = _mm256_set1_ps(s1.real()), s1i = _mm256_set1_ps(s1.imag());
+    const __m256 lane = _mm256_setr_ps(0.f, dW, 2.f * dW, 3.f * dW, 4.f * dW, 5.f * dW, 6.f * dW, 7.f * dW);
+    const __m256 sign = _mm256_set1_ps(-0.f), delta = _mm256_set1_ps(DELTA), one = _mm256_set1_ps(1.f);
+    const __m256 vqa = _mm256_set1_ps(qa), vqb = _mm256_set1_ps(qb), vqd = _mm256_set1_ps(qa - qb);
+    const __m256 k0 = _mm256_set1_ps(c / (2 * Pi));
+    alignas(32) float t0[L], t1[L], t2[L], t3[L], t4[L], t5[L];
+
+    int j = 0;
+    for (; j + L <= n; )
+    {
+        for (int l = 0; l < L; l++) {
+            double w = w0 - (j + l) * dW;
+            complex<double> ea = exp(OneI * (w * qa)), eb = exp(OneI * (w * qb)), e1 = exp(OneI * (w * q1));
+            t0[l] = ea.real(); t1[l] = ea.imag();
+            t2[l] = eb.real(); t3[l] = eb.imag();
+            t4[l] = e1.real(); t5[l] = e1.imag();
+        }
+        __m256 ear = _mm256_load_ps(t0), eai = _mm256_load_ps(t1);
+        __m256 ebr = _mm256_load_ps(t2), ebi = _mm256_load_ps(t3);
+        __m256 e1r = _mm256_load_ps(t4), e1i = _mm256_load_ps(t5);
+        int end = std::min(n, j + RESEED);
+        for (; j + L <= end; j += L)
+        {
+            __m256 w = _mm256_sub_ps(_mm256_set1_ps(w0 - j * dW), lane);
+            __m256 a = _mm256_mul_ps(w, vqa);
+            __m256 b = _mm256_mul_ps(w, vqb);
+            __m256 d = _mm256_mul_ps(w, vqd);
+            __m256 small = _mm256_or_ps(
+                _mm256_or_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign, a), delta, _CMP_LE_OQ),
+                             _mm256_cmp_ps(_mm256_andnot_ps(sign, b), delta, _CMP_LE_OQ)),
+                _mm256_cmp_ps(_mm256_andnot_ps(sign, d), delta, _CMP_LE_OQ));
+            if (_mm256_movemask_ps(small)) {
+                alignas(32) float ta[L], tb[L];
+                _mm256_store_ps(ta, a); _mm256_store_ps(tb, b);
+                _mm256_store_ps(t0, ear); _mm256_store_ps(t1, eai);
+                _mm256_store_ps(t2, ebr); _mm256_store_ps(t3, ebi);
+                _mm256_store_ps(t4, e1r); _mm256_store_ps(t5, e1i);
+                for (int l = 0; l < L; l++) {
+                    double wl = w0 - (j + l) * dW;
+                    res[j + l] = triangle::Integral(ta[l], tb[l], c, wl / (2 * Pi) * complex<double>(t4[l], t5[l]),
+                                                    complex<double>(t0[l], t1[l]), complex<double>(t2[l], t3[l]));
+                }
+            }
+            else {
+                __m256 nr = _mm256_sub_ps(_mm256_mul_ps(a, ebr), _mm256_mul_ps(b, ear));
+                __m256 ni = _mm256_sub_ps(_mm256_mul_ps(a, ebi), _mm256_mul_ps(b, eai));
+                __m256 tr_ = _mm256_sub_ps(_mm256_div_ps(nr, d), one);
+                __m256 ti = _mm256_div_ps(ni, d);
+                __m256 k = _mm256_div_ps(_mm256_mul_ps(w, k0), _mm256_mul_ps(a, b));
+                __m256 rr = _mm256_mul_ps(k, _mm256_sub_ps(_mm256_mul_ps(e1r, tr_), _mm256_mul_ps(e1i, ti)));
+                __m256 ri = _mm256_mul_ps(k, _mm256_add_ps(_mm256_mul_ps(e1r, ti), _mm256_mul_ps(e1i, tr_)));
+                _mm256_store_ps(t0, rr); _mm256_store_ps(t1, ri);
+                for (int l = 0; l < L; l++)
+                    res[j + l] = complex<double>(t0[l], t1[l]);
+            }
+            __m256 r;
+            r = _mm256_sub_ps(_mm256_mul_ps(ear, sar), _mm256_mul_ps(eai, sai));
+            eai = _mm256_add_ps(_mm256_mul_ps(ear, sai), _mm256_mul_ps(eai, sar)); ear = r;
+            r = _mm256_sub_ps(_mm256_mul_ps(ebr, sbr), _mm256_mul_ps(ebi, sbi));
+            ebi = _mm256_add_ps(_mm256_mul_ps(ebr, sbi), _mm256_mul_ps(ebi, sbr)); ebr = r;
+            r = _mm256_sub_ps(_mm256_mul_ps(e1r, s1r), _mm256_mul_ps(e1i, s1i));
+            e1i = _mm256_add_ps(_mm256_mul_ps(e1r, s1i), _mm256_mul_ps(e1i, s1r)); e1r = r;
+        }
+    }
+    for (; j < n; j++)
+        res[j] = tr.Difraction(Nin, Nout, w0 - j * dW);
+}
+
+
+TARGET_AVX512
+static void sweepAvx512Float(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                             complex<double> *res)
+{
+    const int L = 16;
+    rVect V1 = *tr.getV1();
+    rVect v2 = *tr.getV2() - V1;
+    rVect v3 = *tr.getV3() - V1;
+    rVect q = Nin - Nout;
+    double qa = q * v3, qb = q * v2, q1 = q * V1;
+    double c = (v2 ^ v3).length();
+    complex<double> sa = exp(-OneI * (L * dW * qa));
+    complex<double> sb = exp(-OneI * (L * dW * qb));
+    complex<double> s1 = exp(-OneI * (L * dW * q1));
+    const __m512 sar = _mm512_set1_ps(sa.real()), sai = _mm512_set1_ps(sa.imag());
+    const __m512 sbr = _mm512_set1_ps(sb.real()), sbi = _mm512_set1_ps(sb.imag());
+    const __m512 s1r = _mm512_set1_ps(s1.real()), s1i = _mm512_set1_ps(s1.imag());
+    alignas(64) float t0[L], t1[L], t2[L], t3[L], t4[L], t5[L];
+    for (int l = 0; l < L; l++) t0[l] = l * dW;
+    const __m512 lane = _mm512_load_ps(t0);
+    const __m512 delta = _mm512_set1_ps(DELTA), one = _mm512_set1_ps(1.f);
+    const __m512 vqa = _mm512_set1_ps(qa), vqb = _mm512_set1_ps(qb), vqd = _mm512_set1_ps(qa - qb);
+    const __m512 k0 = _mm512_set1_ps(c / (2 * Pi));
+
+    int j = 0;
+    for (; j + L <= n; )
+    {
+        for (int l = 0; l < L; l++) {
+            double w = w0 - (j + l) * dW;
+            complex<double> ea = exp(OneI * (w * qa)), eb = exp(OneI * (w * qb)), e1 = exp(OneI * (w * q1));
+            t0[l] = ea.real(); t1[l] = ea.imag();
+            t2[l] = eb.real(); t3[l] = eb.imag();
+            t4[l] = e1.real(); t5[l] = e1.imag();
+        }
+        __m512 ear = _mm512_load_ps(t0), eai = _mm512_load_ps(t1);
+        __m512 ebr = _mm512_load_ps(t2), ebi = _mm512_load_ps(t3);
+        __m512 e1r = _mm512_load_ps(t4), e1i = _mm512_load_ps(t5);
+        int end = std::min(n, j + RESEED);
+        for (; j + L <= end; j += L)
+        {
+            __m512 w = _mm512_sub_ps(_mm512_set1_ps(w0 - j * dW), lane);
+            __m512 a = _mm512_mul_ps(w, vqa);
+            __m512 b = _mm512_mul_ps(w, vqb);
+            __m512 d = _mm512_mul_ps(w, vqd);
+            __mmask16 small = _mm512_cmp_ps_mask(_mm512_abs_ps(a), delta, _CMP_LE_OQ) |
+                              _mm512_cmp_ps_mask(_mm512_abs_ps(b), delta, _CMP_LE_OQ) |
+                              _mm512_cmp_ps_mask(_mm512_abs_ps(d), delta, _CMP_LE_OQ);
+            if (small) {
+                alignas(64) float ta[L], tb[L];
+                _mm512_store_ps(ta, a); _mm512_store_ps(tb, b);
+                _mm512_store_ps(t0, ear); _mm512_store_ps(t1, eai);
+                _mm512_store_ps(t2, ebr); _mm512_store_ps(t3, ebi);
+                _mm512_store_ps(t4, e1r); _mm512_store_ps(t5, e1i);
+                for (int l = 0; l < L; l++) {
+                    double wl = w0 - (j + l) * dW;
+                    res[j + l] = triangle::Integral(ta[l], tb[l], c, wl / (2 * Pi) * complex<double>(t4[l], t5[l]),
+                                                    complex<double>(t0[l], t1[l]), complex<double>(t2[l], t3[l]));
+                }
+            }
+            else {
+                __m512 nr = _mm512_sub_ps(_mm512_mul_ps(a, ebr), _mm512_mul_ps(b, ear));
+                __m512 ni = _mm512_sub_ps(_mm512_mul_ps(a, ebi), _mm512_mul_ps(b, eai));
+                __m512 tr_ = _mm512_sub_ps(_mm512_div_ps(nr, d), one);
+                __m512 ti = _mm512_div_ps(ni, d);
+                __m512 k = _mm512_div_ps(_mm512_mul_ps(w, k0), _mm512_mul_ps(a, b));
+                __m512 rr = _mm512_mul_ps(k, _mm512_sub_ps(_mm512_mul_ps(e1r, tr_), _mm512_mul_ps(e1i, ti)));
+                __m512 ri = _mm512_mul_ps(k, _mm512_add_ps(_mm512_mul_ps(e1r, ti), _mm512_mul_ps(e1i, tr_)));
+                _mm512_store_ps(t0, rr); _mm512_store_ps(t1, ri);
+                for (int l = 0; l < L; l++)
+                    res[j + l] = complex<double>(t0[l], t1[l]);
+            }
+            __m512 r;
+            r = _mm512_sub_ps(_mm512_mul_ps(ear, sar), _mm512_mul_ps(eai, sai));
+            eai = _mm512_add_ps(_mm512_mul_ps(ear, sai), _mm512_mul_ps(eai, sar)); ear = r;
+            r = _mm512_sub_ps(_mm512_mul_ps(ebr, sbr), _mm512_mul_ps(ebi, sbi));
+            ebi = _mm512_add_ps(_mm512_mul_ps(ebr, sbi), _mm512_mul_ps(ebi, sbr)); ebr = r;
+            r = _mm512_sub_ps(_mm512_mul_ps(e1r, s1r), _mm512_mul_ps(e1i, s1i));
+            e1i = _mm512_add_ps(_mm512_mul_ps(e1r, s1i), _mm512_mul_ps(e1i, s1r)); e1r = r;
+        }
+    }
+    for (; j < n; j++)
+        res[j] = tr.Difraction(Nin, Nout, w0 - j * dW);
+}
+#endif
+
+
+//реестр ядер
+static const solverKernel KERNELS[] = {
+    {"reference",  ISA_SCALAR, 0.,                0, false, sweepReference},
+    {"scalar",     ISA_SCALAR, 1e-10,             1, false, sweepScalar},
+    {"float32",    ISA_SCALAR, REDUCED_TOLERANCE, 2, true,  sweepFloat},
+#if KERNEL_X86
+    {"avx2",       ISA_AVX2,   1e-10,             3, false, sweepAvx2},
+    {"avx2_f32",   ISA_AVX2,   REDUCED_TOLERANCE, 4, true,  sweepAvx2Float},
+    {"avx512",     ISA_AVX512, 1e-10,             5, false, sweepAvx512},
+    {"avx512_f32", ISA_AVX512, REDUCED_TOLERANCE, 6, true,  sweepAvx512Float},
+#endif
+};
+
+
+void solverKernel::refSweep(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                            complex<double> *dOut, complex<double> *dRef, complex<double> *tmp) const
+{
+    if (n == 1) {
+        tr.DifractionRef(Nin, Nout, w0, dOut[0], dRef[0]);
+        return;
+    }
+    rVect NinRef(Nin.getX(), Nin.getY(), -Nin.getZ());
+    rVect NoutRef(Nout.getX(), Nout.getY(), -Nout.getZ());
+    sweep(tr, Nin, Nout, w0, dW, n, dOut);
+    sweep(tr, Nin, NoutRef, w0, dW, n, dRef);
+    //при обратном рассеянии слагаемые (NinRef, Nout) и (Nin, NoutRef) совпадают
+    if (fabs(Nin.getZ() + Nout.getZ()) <= 1.e-12)
+        for (int j = 0; j < n; j++) dOut[j] += dRef[j];
+    else {
+        sweep(tr, NinRef, Nout, w0, dW, n, tmp);
+        for (int j = 0; j < n; j++) dOut[j] += tmp[j];
+    }
+    sweep(tr, NinRef, NoutRef, w0, dW, n, tmp);
+    for (int j = 0; j < n; j++) dRef[j] += tmp[j];
+}
+
+
+static kernelIsa detectIsa()
+{
+#if KERNEL_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int leaves = info[0];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (leaves < 7)) return ISA_SCALAR;
+    //регистры AVX (и AVX-512) должны сохраняться операционной системой
+    unsigned long long xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6) return ISA_SCALAR;
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 16)) && ((xcr0 & 0xE6) == 0xE6)) return ISA_AVX512;
+    if (info[1] & (1 << 5)) return ISA_AVX2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return ISA_AVX512;
+    if (__builtin_cpu_supports("avx2")) return ISA_AVX2;
+#endif
+#endif
+    return ISA_SCALAR;
+}
+
+
+kernelIsa solverKernels::cpuIsa()
+{
+    static const kernelIsa isa = detectIsa();
+    return isa;
+}
+
+
+const char *solverKernels::isaName(kernelIsa isa)
+{
+    switch (isa) {
+    case ISA_AVX2: return "avx2";
+    case ISA_AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+
+std::vector<const solverKernel *> solverKernels::list()
+{
+    std::vector<const solverKernel *> kernels;
+    for (const solverKernel &kernel : KERNELS)
+        if (kernel.isa <= cpuIsa()) kernels.push_back(&kernel);
+    return kernels;
+}
+
+
+const solverKernel *solverKernels::select(double tolerance)
+{
+    const solverKernel *best = &KERNELS[0];
+    for (const solverKernel *kernel : list())
+        if ((kernel->tolerance <= tolerance) && (kernel->speed > best->speed)) best = kernel;
+    return best;
+}
+
+
+const solverKernel *solverKernels::find(const QString &name)
+{
+    for (const solverKernel *kernel : list())
+        if (name == kernel->name) return kernel;
+    return nullptr;
+}
+
+
+//интеграл exp(i*(a*s + b*t)) по треугольнику s, t >= 0, s + t <= 1: замена
+//s = x*(1 - t) и формула Симпсона по x и t
+static complex<double> simplexIntegral(double a, double b)
+{
+    const int N = 64;
+    complex<double> sum;
+    for (int k = 0; k <= N; k++) {
+        double t = 1. * k / N;
+        double wt = ((k == 0) || (k == N)) ? 1. : ((k % 2) ? 4. : 2.);
+        complex<double> inner;
+        for (int l = 0; l <= N; l++) {
+            double x = 1. * l / N;
+            double wx = ((l == 0) || (l == N)) ? 1. : ((l % 2) ? 4. : 2.);
+            inner += wx * exp(OneI * (a * x * (1. - t)));
+        }
+        sum += wt * (1. - t) * exp(OneI * (b * t)) * inner;
+    }
+    return sum / (9. * N * N);
+}
+
+
+double solverKernels::selfCheck()
+{
+    //треугольник V1 = 0, V3 = (1, 0, 0), V2 = (0, 1, 0): a = w*q.x, b = w*q.y
+    node v1(0., 0., 0., true), v2(0., 1., 0., true), v3(1., 0., 0., true);
+    triangle tr(true, &v1, &v2, &v3);
+    const double cases[][2] = { { 2., 1e-3 },       //малая b
+                                { 1e-3, 2. },       //малая a
+                                { 2., 2. + 1e-3 },  //малая a - b
+                                { 1e-3, 2e-3 },     //все фазы малы
+                                { 2., -1.5 } };     //общий случай
+    const int n = 16;
+    const double w0 = 1., dW = 1e-7;
+    rVect Nout(0., 0., 1.);
+    double error = 0.;
+    complex<double> res[n];
+    for (const solverKernel *kernel : list())
+        for (const auto &q : cases) {
+            rVect Nin(q[0], q[1], 1.);
+            kernel->sweep(tr, Nin, Nout, w0, dW, n, res);
+            for (int j = 0; j < n; j++) {
+                double w = w0 - j * dW;
+                complex<double> exact = w / (2 * Pi) * simplexIntegral(w * q[0], w * q[1]);
+                error = std::max(error, std::abs(res[j] - exact) / std::abs(exact));
+            }
+        }
+    return error;
+}
@@ -0,0 +1,57 @@
+#ifndef SOLVER_KERNELS_H
+#define SOLVER_KERNELS_H
+#include "Calc_Radar/Triangle.h"
+#include <QString>
+#include <vector>
+
+/*
+Ядра расчета вклада треугольника на сетке волновых чисел w0 - j*dW.
+Реализации отличаются набором инструкций процессора и точностью; ядро
+выбирается при загрузке задачи по возможностям процессора и требуемой
+точности (поле "accuracy", режим "precision": "float32") или задается
+явно (поле "kernel"). Ядра одинарной точности возвращают вклады в double,
+поле накапливается в double.
+*/
+
+//погрешность ядер пониженной (одинарной) точности
+static const double REDUCED_TOLERANCE = 1e-3;
+//допуск самопроверки: вырожденные случаи интеграла считаются по формулам
+//первого порядка по малой фазе
+static const double SELF_CHECK_TOLERANCE = 1e-2;
+
+//набор инструкций, необходимый ядру
+enum kernelIsa { ISA_SCALAR = 0, ISA_AVX2 = 1, ISA_AVX512 = 2 };
+
+struct solverKernel
+{
+    const char *name;  //имя ядра (передается в метаданных задачи)
+    kernelIsa isa;     //необходимый набор инструкций
+    double tolerance;  //относительная погрешность ядра
+    int speed;         //порядок предпочтения при равной точности (больше - быстрее)
+    bool reduced;      //пониженная точность: результат сверяется с эталоном
+    //вклад треугольника res[j] для направлений Nin, Nout
+    void (*sweep)(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                  complex<double> *res);
+
+    //с подстилающей поверхностью (dOut, dRef как в triangle::DifractionRef),
+    //tmp - рабочий массив из n элементов
+    void refSweep(triangle &tr, rVect Nin, rVect Nout, double w0, double dW, int n,
+                  complex<double> *dOut, complex<double> *dRef, complex<double> *tmp) const;
+};
+
+class solverKernels
+{
+public:
+    static kernelIsa cpuIsa(); //старший набор инструкций процессора
+    static const char *isaName(kernelIsa isa);
+    //самое быстрое из доступных процессору ядер с погрешностью не выше tolerance
+    static const solverKernel *select(double tolerance);
+    //ядро по имени; nullptr, если ядра нет или процессор его не поддерживает
+    static const solverKernel *find(const QString &name);
+    static std::vector<const solverKernel *> list(); //все ядра, доступные процессору
+    //самопроверка ядер на вырожденных случаях интеграла (малые фазы a, b, a - b)
+    //по численному интегрированию: наибольшее относительное отклонение
+    static double selfCheck();
+};
+
+#endif // SOLVER_KERNELS_H
@@ -0,0 +1,94 @@
+#include "Calc_Radar/worker_pool.h"
+#include <chrono>
+#include <algorithm>
+
+//поток пула: вложенный вызов run выполняется в нем же
+static thread_local bool s_poolThread = false;
+
+
+workerPool::~workerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_start.notify_all();
+    for (std::thread &t : m_threads) t.join();
+}
+
+size_t workerPool::take(int thread)
+{
+    size_t n = 0;
+    for (;;) {
+        if (*m_stop && (*m_stop)()) break;
+        size_t i = m_next++;
+        if (i >= m_size) break;
+        (*m_task)(i, thread);
+        m_done++;
+        n++;
+    }
+    return n;
+}
+
+void workerPool::worker(int index)
+{
+    s_poolThread = true;
+    unsigned job = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_start.wait(lock, [&]() { return m_quit || (m_job != job); });
+        if (m_quit) return;
+        job = m_job;
+        if (index >= m_active) continue;
+        lock.unlock();
+        take(index);
+        lock.lock();
+        if (--m_running == 0) m_finish.notify_all();
+    }
+}
+
+size_t workerPool::run(size_t size, int threads, const std::function<void(size_t, int)> &task,
+                       const std::function<bool()> &stop, const std::function<void(size_t)> &progress,
+                       int period)
+{
+    if (size == 0) return 0;
+    if (threads > (int)size) threads = (int)size;
+    //один поток - задачи выполняются вызывающим потоком, прогресс по времени
+    if ((threads <= 1) || s_poolThread) {
+        auto reported = std::chrono::steady_clock::now();
+        size_t i = 0;
+        for (; i < size; i++) {
+            if (stop && stop()) break;
+            task(i, 0);
+            if (progress && (std::chrono::steady_clock::now() - reported >= std::chrono::milliseconds(period))) {
+                progress(i + 1);
+                reported = std::chrono::steady_clock::now();
+            }
+        }
+        return i;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while ((int)m_threads.size() < threads) {
+        int index = (int)m_threads.size();
+        m_threads.push_back(std::thread([this, index]() { worker(index); }));
+    }
+    m_task = &task;
+    m_stop = &stop;
+    m_size = size;
+    m_next = 0;
+    m_done = 0;
+    m_active = threads;
+    m_running = threads;
+    m_job++;
+    m_start.notify_all();
+    while (!m_finish.wait_for(lock, std::chrono::milliseconds(period), [&]() { return m_running == 0; }))
+        if (progress) {
+            lock.unlock();
+            progress(m_done);
+            lock.lock();
+        }
+    m_task = nullptr;
+    m_stop = nullptr;
+    return std::min<size_t>(m_next, size);
+}
@@ -0,0 +1,52 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+/*
+Постоянный пул потоков ядра расчета. потоки создаются при первом расчете с
+нужным их числом и ждут следующего вызова run на условной переменной, поэтому
+вызов не тратит время на запуск потоков. задачи 0..size-1 раздаются по одной в
+порядке номеров; перед выдачей задачи проверяется признак останова, так что
+выданные задачи образуют начало диапазона и все выполняются до конца.
+вызывающий поток задачи не выполняет: он ждет завершения и не реже раза в
+period мсек передает прогресс (сигнал из потоков пула в поток задачи не
+дошел бы - в нем нет цикла событий). вызов run из задачи пула выполняется в
+потоке этой задачи
+*/
+
+class workerPool
+{
+public:
+    ~workerPool();
+    //task(i, thread) для i = 0..size-1 в threads потоках; stop - признак
+    //останова выдачи задач (может быть пустым), progress(done) - прогресс.
+    //возвращает число выданных (выполненных) задач
+    size_t run(size_t size, int threads, const std::function<void(size_t, int)> &task,
+               const std::function<bool()> &stop, const std::function<void(size_t)> &progress,
+               int period);
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;   //новый расчет или завершение пула
+    std::condition_variable m_finish;  //все потоки расчета закончили
+    const std::function<void(size_t, int)> *m_task = nullptr;
+    const std::function<bool()> *m_stop = nullptr;
+    size_t m_size = 0;
+    int m_active = 0;                  //потоков в текущем расчете
+    int m_running = 0;                 //потоков, еще не закончивших расчет
+    unsigned m_job = 0;                //номер расчета
+    bool m_quit = false;
+    std::atomic<size_t> m_next{0};     //следующая задача
+    std::atomic<size_t> m_done{0};     //выполненные задачи
+
+    void worker(int index);
+    size_t take(int thread);           //выполнение задач потоком thread
+};
+
+#endif // WORKER_POOL_H
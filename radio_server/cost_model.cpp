@@ -0,0 +1,106 @@
+#include "cost_model.h"
+#include "calctools.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+//время одного вклада до калибровки, нсек
+static const double DEFAULT_RATE_NS = 200.;
+//вес новой задачи в скользящем среднем
+static const double CALIBRATION_WEIGHT = 0.3;
+//задачи короче этого времени в калибровку не попадают, сек
+static const double MIN_CALIBRATION_TIME = 0.5;
+
+
+//время вклада до калибровки: с подстилающей поверхностью вкладов четыре,
+//вторая поляризация добавляет только поляризационный множитель,
+//ядра одинарной точности обрабатывают вдвое больше частот за команду,
+//время неравномерного fft растет не с произведением числа треугольников
+//на число точек, а с их суммой, и до калибровки принимается в 20 раз меньшим,
+//агрегация кластеров - в 5 раз меньшим
+static double defaultRate(const QString &mode) {
+    double ns = DEFAULT_RATE_NS;
+    if (mode.contains("_ref")) ns *= 4;
+    if (mode.contains("_dual")) ns *= 1.3;
+    if (mode.endsWith("_f32")) ns *= 0.6;
+    if (mode.endsWith("_nufft")) ns *= 0.05;
+    if (mode.endsWith("_cluster")) ns *= 0.2;
+    return ns;
+}
+
+
+costModel &costModel::instance() {
+    static costModel model;
+    return model;
+}
+
+
+costModel::costModel(): m_file("job_timings.json") {
+    load();
+}
+
+
+void costModel::load() {
+    QFile file(m_file);
+    if (!file.open(QIODevice::ReadOnly)) return;
+    QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+    for (auto it = obj.constBegin(); it != obj.constEnd(); ++it) {
+        QJsonObject mode = it.value().toObject();
+        rate r;
+        r.ns = mode.value("ns_per_unit").toDouble(defaultRate(it.key()));
+        r.jobs = mode.value("jobs").toInt();
+        if (r.ns > 0) m_rates.insert(it.key(), r);
+    }
+    clogs("калибровка модели времени расчета загружена из " + m_file, "", "");
+}
+
+
+void costModel::save() {
+    QJsonObject obj;
+    for (auto it = m_rates.constBegin(); it != m_rates.constEnd(); ++it) {
+        QJsonObject mode;
+        mode.insert("ns_per_unit", it.value().ns);
+        mode.insert("jobs", it.value().jobs);
+        obj.insert(it.key(), mode);
+    }
+    QSaveFile file(m_file);
+    if (!file.open(QIODevice::WriteOnly)) {
+        clogs("файл " + m_file + " не может быть открыт", "wrn", "");
+        return;
+    }
+    file.write(QJsonDocument(obj).toJson());
+    file.commit();
+}
+
+
+double costModel::getRate(const QString &mode) {
+    QMutexLocker locker(&m_mutex);
+    if (m_rates.contains(mode)) return m_rates.value(mode).ns;
+    return defaultRate(mode);
+}
+
+
+double costModel::predict(const QString &mode, double units) {
+    return units * getRate(mode) * 1e-9;
+}
+
+
+void costModel::calibrate(const QString &mode, double units, double seconds) {
+    if ((units <= 0) || (seconds < MIN_CALIBRATION_TIME)) return;
+    double ns = seconds / units * 1e9;
+    QMutexLocker locker(&m_mutex);
+    rate r;
+    if (m_rates.contains(mode)) {
+        r = m_rates.value(mode);
+        r.ns = (1. - CALIBRATION_WEIGHT) * r.ns + CALIBRATION_WEIGHT * ns;
+        r.jobs++;
+    }
+    else {
+        r.ns = ns;
+        r.jobs = 1;
+    }
+    m_rates.insert(mode, r);
+    save();
+}
@@ -0,0 +1,46 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#include <QMutex>
+#include <QString>
+#include <QHash>
+
+/*
+Модель времени расчета.
+Стоимость задачи измеряется во вкладах треугольников в поле:
+число освещенных треугольников * число точек сетки (углы * частоты).
+Время одного вклада зависит от режима ядра (без подстилающей поверхности,
+с подстилающей поверхностью и т.д.) и калибруется по завершенным задачам.
+Калибровка хранится на сервере в файле job_timings.json.
+*/
+
+class costModel
+{
+public:
+    static costModel &instance();
+
+    //прогноз времени расчета, сек
+    double predict(const QString &mode, double units);
+    //учет завершенной задачи: units вкладов за seconds сек счета
+    void calibrate(const QString &mode, double units, double seconds);
+    //время одного вклада, нсек
+    double getRate(const QString &mode);
+
+private:
+    costModel();
+    costModel(const costModel &) = delete;
+    costModel &operator=(const costModel &) = delete;
+
+    void load();
+    void save();
+
+    struct rate {
+        double ns;   //время одного вклада, нсек
+        int jobs;    //число задач в калибровке
+    };
+    QMutex m_mutex;
+    QHash<QString, rate> m_rates;
+    QString m_file;
+};
+
+#endif // COST_MODEL_H
@@ -1,5 +1,12 @@
 #include "radar_core.h"
+#include "radar_scheduler.h"
+#include "cost_model.h"
+#include "result_cache.h"
 #include <QDataStream>
+#include <QDir>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 
 QString Txt;
@@ -37,21 +44,61 @@ void radarCore::run() { //запуск главного процесса
             //Прохождение методов расчета радиопортрета
 //            if (!RESULT_FROM_FILE){
                parseJSONtoRadar(Node,Edge);
-               calcRadar();
+               sendEstimate();
+               //ЭПР по азимуту: одна частота, без радиопортрета
+               if (!get_RcsAngles().empty()) {
+                   calcRcs();
+                   m_running = false;
+                   continue;
+               }
+               //ISAR: спектры ракурсов и изображение, радиопортрет не строится
+               if (!get_IsarAngles().empty()) {
+                   calcIsar();
+                   m_running = false;
+                   continue;
+               }
+               //серия ракурсов считается отдельно, результаты передаются по ракурсам
+               if (!get_Aspects().empty()) {
+                   calcSweep();
+                   m_running = false;
+                   continue;
+               }
+               //этап на каждый диапазон: модель и поляризации общие
+               vector<int> bands = get_Bands();
+               m_stages = bands.size();
+               QJsonArray images;
+               for (m_stage = 0; m_stage < m_stages; m_stage++) {
+                   if (m_stages > 1) {
+                       set_Band(bands[m_stage]);
+                       Txt = "расчет в диапазоне " + QString::number(bands[m_stage]) +
+                             " (" + QString::number(m_stage + 1) + " из " +
+                             QString::number(m_stages) + ")"; sendText();
+                   }
+                   m_costAhead = 0;
+                   for (int b = m_stage + 1; b < m_stages; b++) m_costAhead += stageCost(b);
+                   //такой этап уже считался: результат берется из хранилища
+                   if (resultCache::instance().contains(stageKey())) RESULT_FROM_FILE = true;
+                   calcRadar();
+                   Txt = "формирование результата для передачи..."; sendText();
+                   QJsonObject image = calcRadarImage(this);
+                   image.insert("freqBand", bands[m_stage]);
+                   images.push_back(image);
+               }
+               m_stage = m_stages - 1;
 //            }
-            calcRadarResult();
+            calcRadarResult(images);
             m_running = false;
         }
         QTest::qSleep(1000);
         emit finished();
-        emit task_kill(m_Client);;
+        emit task_finished(this);
     }
     catch (int a) {
         if (a == -1) {
            Txt = "ядро остановлено"; sendText();
            QTest::qSleep(1000);
            emit finished();
-           emit task_kill(m_Client);
+           emit task_finished(this);
         }
     }
     catch (std::bad_alloc &ba) {
@@ -59,12 +106,13 @@ void radarCore::run() { //запуск главного процесса
         Txt = "нехватка памяти"; sendText();
         QTest::qSleep(1000);
         emit finished();
-        emit task_kill(m_Client);
+        emit task_finished(this);
     }
 
 }
 
 void radarCore::stop() {
+    Pause(false);
     Exit();
 }
 
@@ -76,14 +124,88 @@ void radarCore::setRadarParam(QJsonDocument &doc, clientAI *client,
 }
 
 
+bool radarCore::subscribe(clientAI *client, QWebSocket *pClient, int id) {
+    QMutexLocker locker(&m_subscribersMutex);
+    radarSubscriber s;
+    s.info = client;
+    s.client = pClient;
+    s.id = id;
+    m_subscribers.push_back(s);
+    //под той же блокировкой, что и рассылка: ни один результат не теряется
+    for (QJsonObject Echo : m_results) {
+        Echo.insert("id", QJsonValue::fromVariant(id));
+        emit send_result(QJsonDocument(Echo).toJson(), pClient);
+    }
+    return m_published;
+}
+
+
+int radarCore::unsubscribe(QWebSocket *pClient) {
+    QMutexLocker locker(&m_subscribersMutex);
+    for (int i = m_subscribers.size() - 1; i >= 0; i--)
+        if (m_subscribers[i].client == pClient) m_subscribers.removeAt(i);
+    return m_subscribers.size();
+}
+
+
+bool radarCore::hasSubscriber(clientAI *client) {
+    QMutexLocker locker(&m_subscribersMutex);
+    for (const radarSubscriber &s : m_subscribers)
+        if (s.info->id == client->id) return true;
+    return false;
+}
+
+
+bool radarCore::isOwner(clientAI *client) {
+    QMutexLocker locker(&m_subscribersMutex);
+    return !m_subscribers.isEmpty() && (m_subscribers.first().info->id == client->id);
+}
+
+
+bool radarCore::isPublished() {
+    QMutexLocker locker(&m_subscribersMutex);
+    return m_published;
+}
+
+
+void radarCore::setPublished() {
+    QMutexLocker locker(&m_subscribersMutex);
+    m_published = true;
+}
+
+
+QList<radarSubscriber> radarCore::subscribers() {
+    QMutexLocker locker(&m_subscribersMutex);
+    return m_subscribers;
+}
+
+
+//рассылка сообщения всем подписчикам; поле id у каждого подписчика свое.
+//результаты запоминаются для подписчиков, присоединившихся позже
+void radarCore::publish(QJsonObject Echo, bool result) {
+    QMutexLocker locker(&m_subscribersMutex);
+    if (result) m_results.push_back(Echo);
+    for (const radarSubscriber &s : m_subscribers) {
+        if (Echo.contains("id")) Echo.insert("id", QJsonValue::fromVariant(s.id));
+        QJsonDocument doc(Echo);
+        if (result) emit send_result(doc.toJson(), s.client);
+        else emit send_text(doc.toJson(), s.client);
+    }
+}
+
+
 void radarCore::pause_core() {
     RUN = false;
+    Pause(true); //остановка в ближайшей точке цикла ФО с записью контрольной точки
+    Txt = "вычислительное ядро на паузе"; sendText();
     return;
 }
 
 
 void radarCore::continue_core() {
     RUN = true;
+    Pause(false);
+    Txt = "продолжение вычислений"; sendText();
     return;
 }
 
@@ -93,12 +215,131 @@ void radarCore::testing(bool test) {
 }
 
 
+//получение кванта расчета у планировщика.
+//очередь упорядочивается по прогнозу оставшегося времени счета
+bool radarCore::begin_Slice(double cost) {
+    double seconds = costModel::instance().predict(culc_Mode(), cost);
+    if (!radarScheduler::instance().acquire(this, seconds, [this]() { return isRun(); }))
+        return false;
+    if (!isRun()) {
+        radarScheduler::instance().release();
+        return false;
+    }
+    m_slice.start();
+    return true;
+}
+
+
+//потоки для расчетов внутри кванта: свой слот и свободные слоты планировщика.
+//свободные слоты занимаются до конца кванта, вне кванта поток один
+int radarCore::culc_Threads() {
+    if (!m_slice.isValid()) return 1;
+    radarScheduler &scheduler = radarScheduler::instance();
+    int want = scheduler.getSlots() - 1 - m_extraSlots;
+    if (want > 0) m_extraSlots += scheduler.acquireFree(want);
+    return 1 + m_extraSlots;
+}
+
+
+void radarCore::end_Slice() {
+    m_busy += m_slice.elapsed() / 1000.;
+    m_slice.invalidate();
+    radarScheduler::instance().release(1 + m_extraSlots);
+    m_extraSlots = 0;
+}
+
+
+//чтение результата из хранилища вместо расчета
+bool radarCore::load_Result(cFields fields) {
+    if (!resultCache::instance().load(stageKey(), fields)) return false;
+    Txt = "результат получен из хранилища"; sendText();
+    return true;
+}
+
+
+void radarCore::store_Result(cFields fields) {
+    resultCache::instance().store(stageKey(), fields);
+}
+
+
+//ключ этапа в хранилище результатов и имя контрольной точки
+QString radarCore::stageKey() {
+    vector<int> bands = get_Bands();
+    if (bands.size() <= 1) return m_hash;
+    return m_hash + "-" + QString::number(bands[m_stage]);
+}
+
+
+//стоимость этапа; этап, результат которого есть в хранилище, не считается
+double radarCore::stageCost(int stage) {
+    int current = m_stage;
+    m_stage = stage;
+    bool cached = resultCache::instance().contains(stageKey());
+    m_stage = current;
+    if (cached) return 0.;
+    return culc_Cost(band_Samples(get_Bands()[stage]));
+}
+
+
+//прогноз времени расчета при постановке задачи
+void radarCore::sendEstimate() {
+    vector<int> bands = get_Bands();
+    size_t samples = 0;
+    double units = 0;
+    for (int b = 0; b < (int)bands.size(); b++) {
+        samples += band_Samples(bands[b]);
+        units += stageCost(b);
+    }
+    //ЭПР: по одной точке на угол
+    if (!get_RcsAngles().empty()) {
+        samples = get_RcsAngles().size();
+        units = culc_Cost(samples);
+    }
+    //ISAR: спектры ракурсов и обратное проецирование
+    else if (!get_IsarAngles().empty()) {
+        samples = isar_Samples();
+        units = culc_Cost(samples);
+    }
+    //в серии каждый ракурс стоит как отдельная задача
+    else if (!get_Aspects().empty()) {
+        samples *= get_Aspects().size();
+        units = culc_Cost(samples);
+    }
+    m_predicted = costModel::instance().predict(culc_Mode(), units);
+
+    QJsonObject Echo;
+    Echo.insert("type", QJsonValue::fromVariant("estimate"));
+    Echo.insert("id", QJsonValue::fromVariant(id));
+    Echo.insert("seconds", m_predicted);
+    Echo.insert("facets", culc_Cost(1));
+    Echo.insert("samples", (double)samples);
+    Echo.insert("mode", culc_Mode());
+    Echo.insert("kernel", kernel_Name());
+    publish(Echo);
+
+    Txt = "прогноз времени расчета " + QString::number(m_predicted, 'f', 1) + " сек"; sendText();
+}
+
+
+//оценка оставшегося времени: в начале расчета по модели, по мере
+//продвижения все больше по фактической скорости
+double radarCore::culc_Eta() {
+    if (m_total == 0) return m_predicted;
+    double ahead = culc_Cost(m_total - m_done) + m_costAhead;
+    double predicted = costModel::instance().predict(culc_Mode(), ahead);
+    if ((m_done <= m_start) || (m_total <= m_start)) return predicted;
+    double f = (double)(m_done - m_start) / (m_total - m_start);
+    double elapsed = m_clock.elapsed() / 1000.;
+    double measured = elapsed * ahead / culc_Cost(m_done - m_start);
+    return (1. - f) * predicted + f * measured;
+}
+
+
 void radarCore::sendText() {
     QJsonObject Echo;
     Echo.insert("type", QJsonValue::fromVariant("answer"));
     Echo.insert("msg", QJsonValue::fromVariant(Txt));
-    QJsonDocument doc(Echo);
-    emit send_text(doc.toJson(), m_Client);
+    publish(Echo);
 }
 
 
@@ -131,6 +372,26 @@ void radarCore::parseJSONtoRadar(QHash<uint, node> &Node, QHash<uint,edge> &Edge
        Txt = "тип радиопортрета не задан"; sendText();
        throw -1;
     }
+    else if(err == 6) {
+       Txt = "проверьте список диапазонов частот"; sendText();
+       throw -1;
+    }
+    else if(err == 7) {
+       Txt = "заданное ядро расчета недоступно на этом сервере"; sendText();
+       throw -1;
+    }
+    else if(err == 8) {
+       Txt = "допуск упрощения модели должен быть положительным"; sendText();
+       throw -1;
+    }
+    else if(err == 9) {
+       Txt = "плоскость симметрии задается четырьмя числами [nx, ny, nz, d]"; sendText();
+       throw -1;
+    }
+    else if(err == 10) {
+       Txt = "для SBR число отражений должно быть не меньше 2, плотность лучей - положительной"; sendText();
+       throw -1;
+    }
     return;
 }
 
@@ -140,7 +401,13 @@ void radarCore::calcRadar() {
     connect(this, &culcradar::signal_send_progress_bar_culcradar,
             this, &radarCore::sendProgressBar);
 
+    //контрольная точка задачи: прерванный расчет продолжается с нее
+    QDir().mkpath("checkpoints");
+    setCheckpoint("checkpoints/" + stageKey() + ".bin");
+
     Txt = "расчет радиопортрета..."; sendText();
+    m_busy = 0;
+    m_clock.start();
     int err;
     err = culc_Eout();
     if(err < 0) {
@@ -149,6 +416,10 @@ void radarCore::calcRadar() {
     }
     else {
        Txt = "расчет радиопортрета завершен успешно"; sendText();
+       //калибровка модели времени расчета по фактическому времени счета
+       costModel::instance().calibrate(culc_Mode(), culc_Cost(m_done - m_start), m_busy);
+       clogs("время счета " + QString::number(m_busy, 'f', 1) + " сек, прогноз " +
+             QString::number(m_predicted, 'f', 1) + " сек", "", "");
     }
 
     disconnect(this, &culcradar::signal_send_progress_bar_culcradar,
@@ -157,21 +428,15 @@ void radarCore::calcRadar() {
 }
 
 
-void radarCore::calcRadarResult() {
-    Txt = "формирование результата для передачи..."; sendText();
+//радиопортрет текущего этапа ядра core для передачи клиенту
+QJsonObject radarCore::calcRadarImage(culcradar *core) {
 
-    //Инициализация передаваемого json-документа
     QJsonObject Echo;
-    QJsonDocument doc;
-    //вставка в JSON-документ служебной информации
-    Echo.insert("type", QJsonValue::fromVariant("result"));
-    Echo.insert("id", QJsonValue::fromVariant(id));
-    Echo.insert("content", QJsonValue::fromVariant("radioportrait"));
 
     //размеры массивов
-    uint size1 = getSizeEoutX();
-    uint size2 = getSizeEoutY();
-    uint size3 = getSizeEoutZ();
+    uint size1 = core->getSizeEoutX();
+    uint size2 = core->getSizeEoutY();
+    uint size3 = core->getSizeEoutZ();
 
     //инициализация json-массивов для заполнения полем рассеяния
     QJsonArray m_fft_absEout = {};  //длина векторов (abs)
@@ -179,20 +444,20 @@ void radarCore::calcRadarResult() {
     QJsonArray m_fft_Eout_base = {}; //по основной поляризации (basis)
     QJsonArray m_fft_Eout_cross = {}; //по кросс-поляризации (cross)
     cVect Eout_base, Eout_cross; //E по осн. поляризации и кроссполяризации
-    rVect rEin = this->getEin();
+    rVect rEin = core->getEin();
     std::complex<double> dotE;
 
     //вычисление границ объекта
-    double Lmax = get_Lmax();
+    double Lmax = core->get_Lmax();
     uint n, m, q;
     n = 0; m = 0; q = 0;
     double stepX, stepY, stepZ;
-    stepX = get_stepX();
-    stepY = get_stepY();
-    stepZ = get_stepZ();
-    if (stepX > 0) n = Lmax / get_stepX();
-    if (stepY > 0) m = Lmax / get_stepY();
-    if (stepZ > 0) q = Lmax / get_stepZ();
+    stepX = core->get_stepX();
+    stepY = core->get_stepY();
+    stepZ = core->get_stepZ();
+    if (stepX > 0) n = Lmax / core->get_stepX();
+    if (stepY > 0) m = Lmax / core->get_stepY();
+    if (stepZ > 0) q = Lmax / core->get_stepZ();
 
     //вычисление отступа от края портрета
     uint n1 = round((size1 - n)/2);
@@ -222,12 +487,12 @@ void radarCore::calcRadarResult() {
             QJsonArray m_fft_absX = {};
             QJsonArray m_fft_normX = {};
             for (uint k = 0; k < size1; k++) {
-               Eout_base = getEout(k + n1,j + m1,i + q1);
-               dotE = dot(Eout_base,rEin);
+               Eout_base = core->getEout(k + n1,j + m1,i + q1);
+               dotE = core->dot(Eout_base,rEin);
                Eout_base = dotE * rEin; //расс. поле осн. поляризации
-               radar_wave RW = getRWave();
+               radar_wave RW = core->getRWave();
                if (RW.getIncPolariz() != RW.getRefPolariz()) {
-                  Eout_cross = Eout_base - getEout(k + n1,j + m1,i + q1); //расс. поле кросс-поляризации
+                  Eout_cross = Eout_base - core->getEout(k + n1,j + m1,i + q1); //расс. поле кросс-поляризации
                   Eout_base = Eout_cross;
                }
 //               Eout_cross = Eout_base - getEout(k,j,i); //расс. поле кросс-поляризации
@@ -263,6 +528,41 @@ void radarCore::calcRadarResult() {
          if (i == q) break;
     }
 
+    //матрица рассеяния: первая буква - поляризация излучения, вторая - приема
+    QJsonObject m_scatMatrix;
+    if (core->get_dual()) {
+        rVect recV = core->getEinV(), recH = core->getEinH();
+        bool incV = (core->getRWave().getIncPolariz() == 0);
+        QJsonArray VV = {}, VH = {}, HV = {}, HH = {};
+        for (uint i = 0; i < size3; i++) {
+            QJsonArray VVy = {}, VHy = {}, HVy = {}, HHy = {};
+            for (uint j = 0; j < size2; j++) {
+                QJsonArray VVx = {}, VHx = {}, HVx = {}, HHx = {};
+                for (uint k = 0; k < size1; k++) {
+                    cVect E1 = core->getEout(k + n1, j + m1, i + q1);  //излучение Ein
+                    cVect E2 = core->getEout2(k + n1, j + m1, i + q1); //излучение Ein2
+                    cVect &Ev = incV ? E1 : E2;
+                    cVect &Eh = incV ? E2 : E1;
+                    VVx.push_back(std::abs(core->dot(Ev, recV)));
+                    VHx.push_back(std::abs(core->dot(Ev, recH)));
+                    HVx.push_back(std::abs(core->dot(Eh, recV)));
+                    HHx.push_back(std::abs(core->dot(Eh, recH)));
+                    if (k == n) break;
+                }
+                VVy.push_back(VVx); VHy.push_back(VHx);
+                HVy.push_back(HVx); HHy.push_back(HHx);
+                if (j == m) break;
+            }
+            VV.push_back(VVy); VH.push_back(VHy);
+            HV.push_back(HVy); HH.push_back(HHy);
+            if (i == q) break;
+        }
+        m_scatMatrix.insert("VV", VV);
+        m_scatMatrix.insert("VH", VH);
+        m_scatMatrix.insert("HV", HV);
+        m_scatMatrix.insert("HH", HH);
+    }
+
     //вставка в json-документ информации о размерах json-массивов
     //(0-одномерн., 1-двумерн., 2-трехмерн., -1-единичн.):
     if ((size3 == 1) && (size2 == 1) && (size1 > 1)) {
@@ -299,11 +599,45 @@ void radarCore::calcRadarResult() {
     Echo.insert("info_absEout",QString("fft result, absolute value"));
     Echo.insert("normEout",m_fft_normEout);
     Echo.insert("info_normEout",QString("fft result, norm value"));
+    if (core->get_dual()) {
+        Echo.insert("scatMatrix",m_scatMatrix);
+        Echo.insert("info_scatMatrix",QString("fft result, absolute value of polarization channels (transmit, receive)"));
+    }
+    //ускоренный метод, которым выполнен расчет (после отказа от него - прямое суммирование)
+    if (!core->get_Engine().isEmpty()) Echo.insert("engine", core->get_Engine());
+    //расчет с пониженной точностью: отклонение от эталона
+    if (core->get_PrecisionError() >= 0) {
+        Echo.insert("precision_error", core->get_PrecisionError());
+        Echo.insert("info_precision_error",QString("max deviation from double reference on verified samples, relative to their peak"));
+    }
+    return Echo;
+}
+
+
+//передача результата: радиопортрет первого диапазона на верхнем уровне,
+//радиопортреты всех диапазонов многодиапазонной задачи - в массиве bands
+QJsonObject radarCore::resultMessage(QJsonArray images) {
+    //Инициализация передаваемого json-документа
+    QJsonObject Echo = images.isEmpty() ? QJsonObject() : images[0].toObject();
+    //вставка в JSON-документ служебной информации
+    Echo.insert("type", QJsonValue::fromVariant("result"));
+    Echo.insert("id", QJsonValue::fromVariant(id));
+    Echo.insert("content", QJsonValue::fromVariant("radioportrait"));
+    Echo.insert("kernel", kernel_Name());
+    if (get_Deterministic()) Echo.insert("deterministic", true);
+    if (images.size() > 1) Echo.insert("bands", images);
+    return Echo;
+}
+
+
+void radarCore::calcRadarResult(QJsonArray images) {
+    QJsonObject Echo = resultMessage(images);
 
     Txt = "передача результата клиенту"; sendText();
     //Send document to client
     QJsonDocument doc1(Echo);
-    emit send_result(doc1.toJson(), m_Client);
+    publish(Echo, true);
+    setPublished();
 
     //Сохранение сообщения клиенту в json и бинарный файл
     if (SAVE_MESSAGE_TO_FILE) {
@@ -338,6 +672,232 @@ void radarCore::calcRadarResult() {
 }
 
 
+//ядро одного ракурса серии: получает кванты у планировщика от своего имени,
+//поэтому ракурсы распределяются по всем слотам вычислителя
+bool radarAspect::begin_Slice(double cost) {
+    double seconds = costModel::instance().predict(culc_Mode(), cost);
+    if (!radarScheduler::instance().acquire(this, seconds, [this]() { return isRun(); }))
+        return false;
+    if (!isRun()) {
+        radarScheduler::instance().release();
+        return false;
+    }
+    m_slice.start();
+    return true;
+}
+
+
+void radarAspect::end_Slice() {
+    m_busy += m_slice.elapsed() / 1000.;
+    radarScheduler::instance().release();
+}
+
+
+bool radarAspect::load_Result(cFields fields) {
+    return resultCache::instance().load(m_key, fields);
+}
+
+
+void radarAspect::store_Result(cFields fields) {
+    resultCache::instance().store(m_key, fields);
+}
+
+
+//расчет ракурсов серии одним ядром: ракурсы берутся из общего счетчика next
+void radarCore::sweepWorker(radarAspect *core, std::atomic<size_t> &next) {
+    vector<rVect> aspects = get_Aspects();
+    vector<int> bands = get_Bands();
+    int inc_polariz = getRWave().getIncPolariz();
+    int ref_polariz = getRWave().getRefPolariz();
+    for (size_t a = next++; (a < aspects.size()) && isRun(); a = next++) {
+        core->set_Direction(aspects[a], inc_polariz, ref_polariz);
+        QJsonArray images;
+        for (size_t b = 0; b < bands.size(); b++) {
+            if (bands.size() > 1) core->set_Band(bands[b]);
+            core->m_key = m_hash + "-a" + QString::number(a);
+            if (bands.size() > 1) core->m_key += "-" + QString::number(bands[b]);
+            core->RESULT_FROM_FILE = resultCache::instance().contains(core->m_key);
+            if (core->culc_Eout() < 0) return;
+            core->finish_Stage();
+            QJsonObject image = calcRadarImage(core);
+            image.insert("freqBand", bands[b]);
+            images.push_back(image);
+        }
+        //результат ракурса передается сразу после расчета
+        QJsonObject Echo = resultMessage(images);
+        QJsonObject direct;
+        direct.insert("x", aspects[a].getX());
+        direct.insert("y", aspects[a].getY());
+        direct.insert("z", aspects[a].getZ());
+        Echo.insert("aspect", (int)a);
+        Echo.insert("aspects", (int)aspects.size());
+        Echo.insert("directVector", direct);
+        publish(Echo, true);
+    }
+}
+
+
+//серия ракурсов: модель загружена один раз, ракурсы считаются параллельно
+//ядрами radarAspect, каждое получает кванты у планировщика от своего имени.
+//рассчитанные ракурсы остаются в хранилище, поэтому прерванная серия
+//продолжается с первого не рассчитанного ракурса
+void radarCore::calcSweep() {
+    vector<rVect> aspects = get_Aspects();
+    vector<int> bands = get_Bands();
+    size_t perAspect = 0;
+    for (int band : bands) perAspect += band_Samples(band);
+    m_total = aspects.size() * perAspect;
+    m_start = 0; m_done = 0;
+
+    int workers = qMin<int>(radarScheduler::instance().getSlots(), aspects.size());
+    Txt = "расчет серии из " + QString::number(aspects.size()) + " ракурсов (" +
+          QString::number(workers) + " потоков)"; sendText();
+
+    vector<radarAspect*> cores;
+    for (int i = 0; i < workers; i++) {
+        radarAspect *core = new radarAspect;
+        core->copy_Model(*this);
+        core->CHECKPOINT_INTERVAL = 0;
+        cores.push_back(core);
+    }
+    std::atomic<size_t> next(0);
+    int running = workers;
+    std::mutex runningMutex;
+    std::condition_variable finished;
+    vector<std::thread> threads;
+    for (int i = 0; i < workers; i++)
+        threads.push_back(std::thread([&, i]() {
+            sweepWorker(cores[i], next);
+            std::lock_guard<std::mutex> lock(runningMutex);
+            if (--running == 0) finished.notify_all();
+        }));
+
+    //ожидание ядер: передача прогресса, пауза и остановка
+    m_busy = 0;
+    m_clock.start();
+    progress = 0;
+    count = true;
+    sendProgressBar();
+    std::unique_lock<std::mutex> lock(runningMutex);
+    while (!finished.wait_for(lock, std::chrono::milliseconds(200), [&]() { return running == 0; })) {
+        lock.unlock();
+        for (radarAspect *core : cores) {
+            core->Pause(isPaused());
+            if (!isRun()) core->Exit();
+        }
+        size_t done = 0;
+        for (radarAspect *core : cores) done += core->m_finished + core->getDone();
+        m_done = qMin(done, m_total);
+        int p = (int)(100. * m_done / m_total);
+        if ((p != progress) && (p < 100)) {
+            progress = p;
+            sendProgressBar();
+        }
+        lock.lock();
+    }
+    lock.unlock();
+    for (std::thread &t : threads) t.join();
+    for (radarAspect *core : cores) m_busy += core->m_busy;
+    //ядра удаляются сразу: таймер прогресс-бара останавливается с ожиданием своего потока
+    for (radarAspect *core : cores) delete core;
+
+    if (!isRun()) throw -1;
+    costModel::instance().calibrate(culc_Mode(), culc_Cost(perAspect) * aspects.size(), m_busy);
+    progress = 100;
+    sendProgressBar();
+    setPublished();
+    Txt = "расчет серии ракурсов завершен успешно"; sendText();
+}
+
+
+//ЭПР по азимуту: результат - одномерная кривая, fft не выполняется
+void radarCore::calcRcs() {
+    connect(this, &culcradar::signal_send_progress_bar_culcradar,
+            this, &radarCore::sendProgressBar);
+
+    vector<double> angles = get_RcsAngles();
+    Txt = "расчет ЭПР в " + QString::number(angles.size()) + " точках..."; sendText();
+    m_busy = 0;
+    m_clock.start();
+    vector<double> sigma;
+    if (culc_Rcs(sigma) < 0) {
+        Txt = "расчет ЭПР завершен с ошибкой"; sendText();
+        throw -1;
+    }
+    costModel::instance().calibrate(culc_Mode(), culc_Cost(angles.size()), m_busy);
+    disconnect(this, &culcradar::signal_send_progress_bar_culcradar,
+               this, &radarCore::sendProgressBar);
+
+    QJsonArray jAngles, jSigma, jDbsm;
+    for (size_t i = 0; i < angles.size(); i++) {
+        jAngles.push_back(angles[i]);
+        jSigma.push_back(sigma[i]);
+        jDbsm.push_back(10. * log10(qMax(sigma[i], 1e-30)));
+    }
+    QJsonObject Echo;
+    Echo.insert("type", QJsonValue::fromVariant("result"));
+    Echo.insert("id", QJsonValue::fromVariant(id));
+    Echo.insert("content", QJsonValue::fromVariant("rcs"));
+    Echo.insert("kernel", kernel_Name());
+    Echo.insert("freqBand", getRWave().getBand());
+    Echo.insert("angles", jAngles);
+    Echo.insert("info_angles", QString("azimuth rotation of direct vector, deg"));
+    Echo.insert("rcs", jSigma);
+    Echo.insert("info_rcs", QString("monostatic rcs, m^2"));
+    Echo.insert("rcs_dbsm", jDbsm);
+    Echo.insert("info_rcs_dbsm", QString("monostatic rcs, dBsm"));
+
+    Txt = "передача результата клиенту"; sendText();
+    publish(Echo, true);
+    setPublished();
+}
+
+
+//ISAR: результат - изображение в плоскости XY модели
+void radarCore::calcIsar() {
+    connect(this, &culcradar::signal_send_progress_bar_culcradar,
+            this, &radarCore::sendProgressBar);
+
+    Txt = "расчет ISAR по " + QString::number(get_IsarAngles().size()) + " ракурсам..."; sendText();
+    m_busy = 0;
+    m_clock.start();
+    vector<vector<double>> image;
+    double x0, y0, pixel;
+    if (culc_Isar(image, x0, y0, pixel) < 0) {
+        Txt = "расчет ISAR завершен с ошибкой"; sendText();
+        throw -1;
+    }
+    costModel::instance().calibrate(culc_Mode(), culc_Cost(isar_Samples()), m_busy);
+    disconnect(this, &culcradar::signal_send_progress_bar_culcradar,
+               this, &radarCore::sendProgressBar);
+
+    QJsonArray jImage;
+    for (size_t iy = 0; iy < image.size(); iy++) {
+        QJsonArray jRow;
+        for (size_t ix = 0; ix < image[iy].size(); ix++)
+            jRow.push_back(image[iy][ix]);
+        jImage.push_back(jRow);
+    }
+    QJsonObject Echo;
+    Echo.insert("type", QJsonValue::fromVariant("result"));
+    Echo.insert("id", QJsonValue::fromVariant(id));
+    Echo.insert("content", QJsonValue::fromVariant("isar"));
+    Echo.insert("kernel", kernel_Name());
+    Echo.insert("freqBand", getRWave().getBand());
+    Echo.insert("image", jImage);
+    Echo.insert("info_image", QString("isar image magnitude [y][x]"));
+    Echo.insert("size", (int)image.size());
+    Echo.insert("pixel", pixel);
+    Echo.insert("originX", x0);
+    Echo.insert("originY", y0);
+    Echo.insert("info_origin", QString("coordinates of pixel [0][0], m"));
+
+    Txt = "передача результата клиенту"; sendText();
+    publish(Echo, true);
+    setPublished();
+}
+
+
 void radarCore::sendProgressBar() {
     QJsonObject Echo;
     Echo.insert("type", QJsonValue::fromVariant("progress_bar"));
@@ -351,12 +911,17 @@ void radarCore::sendProgressBar() {
         Echo.insert("status", QJsonValue::fromVariant("done"));
         //Echo.insert("content", QJsonValue::fromVariant(progress));
     }
+    else if (isPaused()) {
+        Echo.insert("status", QJsonValue::fromVariant("pause"));
+        //Echo.insert("content", QJsonValue::fromVariant(progress));
+    }
     else {
         Echo.insert("status", QJsonValue::fromVariant("work"));
         //Echo.insert("content", QJsonValue::fromVariant(progress));
     }
     Echo.insert("content", QJsonValue::fromVariant(progress));
+    if (progress < 100) Echo.insert("eta", culc_Eta());
+    if (m_clock.isValid()) Echo.insert("elapsed", m_clock.elapsed() / 1000.);
     //Echo.insert("msg", QJsonValue::fromVariant(progress));
-    QJsonDocument doc(Echo);
-    emit send_progress_bar(doc.toJson(), m_Client);
+    publish(Echo);
 }
@@ -7,8 +7,38 @@
 #include "clientai.h"
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QList>
 #include "Calc_Radar/CulcRadar.h"
 
+//подписчик задачи: клиент, получающий прогресс и результат расчета
+struct radarSubscriber {
+    clientAI *info;
+    QWebSocket *client;
+    int id;  //идентификатор объекта у клиента
+};
+
+//ядро одного ракурса серии ракурсов
+class radarAspect : public culcradar
+{
+public:
+    QString m_key;                 //ключ ракурса в хранилище результатов
+    std::atomic<size_t> m_finished{0}; //точки, рассчитанные в завершенных этапах
+    double m_busy = 0;             //время счета в квантах, сек
+    size_t getDone() { return m_done; }
+    void finish_Stage() { m_finished += m_done; m_done = 0; }
+
+protected:
+    bool begin_Slice(double cost) override;
+    void end_Slice() override;
+    bool load_Result(cFields fields) override;
+    void store_Result(cFields fields) override;
+
+private:
+    QElapsedTimer m_slice;
+};
+
 class radarCore : public culcradar
 {
    Q_OBJECT
@@ -29,17 +59,28 @@ private:
    clientAI *m_clientRadar;
    QWebSocket *m_Client;
    QJsonDocument m_doc;
+   QString m_hash;          //хеш содержимого задачи
+   QList<radarSubscriber> m_subscribers;
+   QList<QJsonObject> m_results; //переданные результаты: повторяются новым подписчикам
+   bool m_published = false;     //результат задачи передан полностью
+   QMutex m_subscribersMutex;
+   QElapsedTimer m_clock;   //время с начала расчета
+   QElapsedTimer m_slice;   //время текущего кванта
+   int m_extraSlots = 0;    //дополнительные слоты планировщика в текущем кванте
+   double m_busy = 0;       //время счета в квантах, сек
+   double m_predicted = 0;  //прогноз времени счета при постановке задачи, сек
 
 public slots:
     void run();
     void sendText();     //method of sending text messages
     void sendProgressBar();
+  void sendEstimate();   //прогноз времени расчета
     void pause_core();
     void stop();
 
 signals:
   void finished();
-  void task_kill(QWebSocket *Client);
+  void task_finished(radarCore *Core);
   void send_text(QString doc, QWebSocket *Client);
   void send_progress_bar (QString doc, QWebSocket *Client);
   void send_result (QString doc, QWebSocket *Client);
@@ -51,13 +92,43 @@ public:
   void setRadarParam(QJsonDocument &doc, clientAI *client, QWebSocket *pClient);
   clientAI* getClientRadar() {return m_clientRadar;}
   uint getModelId() {return model_id;}
+  void setJobHash(const QString &hash) {m_hash = hash;}
+  QString getJobHash() {return m_hash;}
+
+  //подписчики задачи: одинаковые задачи разных клиентов считаются один раз.
+  //новому подписчику повторяются уже переданные результаты; subscribe
+  //возвращает true, если результат задачи был передан полностью
+  bool subscribe(clientAI *client, QWebSocket *pClient, int id);
+  int unsubscribe(QWebSocket *pClient);  //возвращает число оставшихся подписчиков
+  bool hasSubscriber(clientAI *client);
+  bool isOwner(clientAI *client); //владелец - первый из оставшихся подписчиков
+  bool isPublished();
+  void setPublished();
+  QList<radarSubscriber> subscribers();
+  void publish(QJsonObject Echo, bool result = false); //рассылка всем подписчикам
 
   void continue_core();
   void testing(bool test);
 
   void parseJSONtoRadar(QHash<uint, node> &Node, QHash<uint,edge> &Edge);
   void calcRadar();
-  void calcRadarResult();
+  QJsonObject calcRadarImage(culcradar *core);
+  QJsonObject resultMessage(QJsonArray images);
+  void calcRadarResult(QJsonArray images);
+  void calcSweep();      //серия ракурсов
+  void calcRcs();        //ЭПР по азимуту
+  void calcIsar();       //изображение ISAR
+  void sweepWorker(radarAspect *core, std::atomic<size_t> &next);
+  double culc_Eta();     //оценка оставшегося времени расчета, сек
+  QString stageKey();    //ключ текущего этапа (диапазона) задачи
+  double stageCost(int stage);
+
+protected:
+  bool begin_Slice(double cost) override;
+  void end_Slice() override;
+  bool load_Result(cFields fields) override;
+  void store_Result(cFields fields) override;
+  int culc_Threads() override;
 };
 
 #endif // RADAR_CORE_H
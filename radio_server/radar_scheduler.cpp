@@ -0,0 +1,100 @@
+#include "radar_scheduler.h"
+#include <QThread>
+
+//время ожидания (мсек), за которое стоимость ожидающей задачи уменьшается вдвое
+static const double AGING_MS = 30000.;
+
+
+radarScheduler &radarScheduler::instance() {
+    static radarScheduler scheduler;
+    return scheduler;
+}
+
+
+radarScheduler::radarScheduler():
+    m_slots(qMax(1, QThread::idealThreadCount())), m_busy(0) {
+    m_clock.start();
+}
+
+
+void radarScheduler::setSlots(int n) {
+    QMutexLocker locker(&m_mutex);
+    m_slots = qMax(1, n);
+    m_cond.wakeAll();
+}
+
+
+int radarScheduler::getSlots() {
+    QMutexLocker locker(&m_mutex);
+    return m_slots;
+}
+
+
+int radarScheduler::getBusy() {
+    QMutexLocker locker(&m_mutex);
+    return m_busy;
+}
+
+
+int radarScheduler::getWaiting() {
+    QMutexLocker locker(&m_mutex);
+    return m_waiting.size();
+}
+
+
+//следующей слот получает задача с наименьшей приведенной стоимостью
+bool radarScheduler::isNext(const void *ticket) {
+    qint64 now = m_clock.elapsed();
+    const request *best = nullptr;
+    double best_cost = 0;
+    for (const request &r : m_waiting) {
+        double cost = r.cost / (1. + (now - r.since) / AGING_MS);
+        if ((best == nullptr) || (cost < best_cost)) {
+            best = &r;
+            best_cost = cost;
+        }
+    }
+    return (best != nullptr) && (best->ticket == ticket);
+}
+
+
+bool radarScheduler::acquire(const void *ticket, double cost, std::function<bool()> alive) {
+    QMutexLocker locker(&m_mutex);
+    request r;
+    r.ticket = ticket;
+    r.cost = cost;
+    r.since = m_clock.elapsed();
+    m_waiting.push_back(r);
+
+    while ((m_busy >= m_slots) || !isNext(ticket)) {
+        //периодическая проверка: задача могла быть остановлена во время ожидания
+        m_cond.wait(&m_mutex, 200);
+        if (!alive()) {
+            for (int i = 0; i < m_waiting.size(); i++)
+                if (m_waiting[i].ticket == ticket) { m_waiting.removeAt(i); break; }
+            m_cond.wakeAll();
+            return false;
+        }
+    }
+    for (int i = 0; i < m_waiting.size(); i++)
+        if (m_waiting[i].ticket == ticket) { m_waiting.removeAt(i); break; }
+    m_busy++;
+    m_cond.wakeAll();
+    return true;
+}
+
+
+int radarScheduler::acquireFree(int n) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_waiting.isEmpty()) return 0;
+    n = qMax(0, qMin(n, m_slots - m_busy));
+    m_busy += n;
+    return n;
+}
+
+
+void radarScheduler::release(int n) {
+    QMutexLocker locker(&m_mutex);
+    m_busy = qMax(0, m_busy - n);
+    m_cond.wakeAll();
+}
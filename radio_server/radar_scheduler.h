@@ -0,0 +1,58 @@
+#ifndef RADAR_SCHEDULER_H
+#define RADAR_SCHEDULER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QList>
+#include <functional>
+
+/*
+Планировщик вычислительных слотов.
+Число одновременно считающих задач ограничено числом слотов. Задача считает
+квантами: перед квантом запрашивает слот (acquire), после кванта освобождает
+его (release). Свободный слот получает ожидающая задача с наименьшей оставшейся
+стоимостью, поэтому короткие задачи не стоят в очереди за длинными.
+Чтобы длинные задачи не голодали, стоимость ожидающей задачи уменьшается
+со временем ожидания.
+*/
+
+class radarScheduler
+{
+public:
+    static radarScheduler &instance();
+
+    void setSlots(int n);
+    int getSlots();
+    int getBusy();
+    int getWaiting();
+
+    //запрос кванта: ожидание свободного слота.
+    //cost - оставшаяся стоимость задачи, alive - признак того, что задача еще нужна
+    bool acquire(const void *ticket, double cost, std::function<bool()> alive);
+    //дополнительные слоты для потоков кванта: до n свободных слотов без
+    //ожидания, если в очереди нет задач. возвращает число полученных слотов
+    int acquireFree(int n);
+    void release(int n = 1);
+
+private:
+    radarScheduler();
+    radarScheduler(const radarScheduler &) = delete;
+    radarScheduler &operator=(const radarScheduler &) = delete;
+
+    struct request {
+        const void *ticket;
+        double cost;
+        qint64 since; //время постановки в очередь, мсек
+    };
+    bool isNext(const void *ticket); //очередь задачи на получение слота
+
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    QElapsedTimer m_clock;
+    QList<request> m_waiting;
+    int m_slots;
+    int m_busy;
+};
+
+#endif // RADAR_SCHEDULER_H
@@ -14,10 +14,18 @@ CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
 SOURCES += \
         Calc_Radar/CulcRadar.cpp \
         Calc_Radar/Radar_Wave.cpp \
+        Calc_Radar/mesh_decimation.cpp \
+        Calc_Radar/bvh.cpp \
+        Calc_Radar/sbr.cpp \
+        Calc_Radar/solver_kernels.cpp \
+        Calc_Radar/worker_pool.cpp \
         calctools.cpp \
         clientai.cpp \
+        cost_model.cpp \
         main.cpp \
         radar_core.cpp \
+        radar_scheduler.cpp \
+        result_cache.cpp \
         webserver.cpp
 
 # Default rules for deployment.
@@ -30,15 +38,26 @@ HEADERS += \
     Calc_Radar/ConstAndVar.h \
     Calc_Radar/CulcRadar.h \
     Calc_Radar/Edge.h \
+    Calc_Radar/NUFFT.h \
     Calc_Radar/Node.h \
+    Calc_Radar/Polygon.h \
+    Calc_Radar/CurvedPatch.h \
     Calc_Radar/Radar_Wave.h \
     Calc_Radar/Triangle.h \
     Calc_Radar/VectFFT.h \
     Calc_Radar/cVect.h \
+    Calc_Radar/mesh_decimation.h \
+    Calc_Radar/bvh.h \
+    Calc_Radar/sbr.h \
     Calc_Radar/rMatrix.h \
     Calc_Radar/rVect.h \
+    Calc_Radar/solver_kernels.h \
+    Calc_Radar/worker_pool.h \
     calctools.h \
     clientai.h \
+    cost_model.h \
     radar_core.h \
+    radar_scheduler.h \
+    result_cache.h \
     timer.h \
     webserver.h
@@ -0,0 +1,145 @@
+#include "result_cache.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+
+//признак и версия формата записи хранилища
+static const quint32 CACHE_MAGIC = 0x52524553; //"RRES"
+static const quint32 CACHE_VERSION = 6;
+//объем хранилища по умолчанию, байт
+static const qint64 DEFAULT_CAPACITY = 2LL * 1024 * 1024 * 1024;
+
+
+resultCache &resultCache::instance() {
+    static resultCache cache;
+    return cache;
+}
+
+
+resultCache::resultCache(): m_dir("result_cache"), m_capacity(DEFAULT_CAPACITY) {
+    QDir().mkpath(m_dir);
+}
+
+
+QString resultCache::fileName(const QString &key) {
+    return m_dir + "/" + key + ".bin";
+}
+
+
+bool resultCache::contains(const QString &key) {
+    if (key.isEmpty()) return false;
+    QMutexLocker locker(&m_mutex);
+    return QFile::exists(fileName(key));
+}
+
+
+bool resultCache::load(const QString &key, cFields fields) {
+    if (key.isEmpty()) return false;
+    QMutexLocker locker(&m_mutex);
+    QFile file(fileName(key));
+    //запись открывается на чтение и запись, чтобы обновить время обращения
+    if (!file.open(QIODevice::ReadWrite)) return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic, version, nFields, sX, sY, sZ;
+    stream >> magic >> version >> nFields >> sX >> sY >> sZ;
+    if ((stream.status() != QDataStream::Ok) || (magic != CACHE_MAGIC) ||
+        (version != CACHE_VERSION) || (nFields != fields.size()) ||
+        (sX == 0) || (sY == 0) || (sZ == 0)) {
+        clogs("запись хранилища " + key + " повреждена", "wrn", "");
+        file.close();
+        file.remove();
+        return false;
+    }
+    vector<cField> result(nFields, cField(sZ, vector<vector<cVect>>(sY, vector<cVect>(sX))));
+    for (cField &field : result)
+        if (!culcradar::read_Field(stream, field)) {
+            clogs("запись хранилища " + key + " повреждена", "wrn", "");
+            file.close();
+            file.remove();
+            return false;
+        }
+    //отметка обращения для вытеснения давно не использованных записей
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    file.close();
+    for (size_t i = 0; i < fields.size(); i++)
+        *fields[i] = result[i];
+    clogs("результат " + key + " прочитан из хранилища", "", "");
+    return true;
+}
+
+
+void resultCache::store(const QString &key, cFields fields) {
+    if (key.isEmpty() || fields.empty() || fields[0]->empty()) return;
+    QMutexLocker locker(&m_mutex);
+    QSaveFile file(fileName(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        clogs("запись хранилища " + key + " не может быть открыта", "wrn", "");
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    cField &field = *fields[0];
+    stream << CACHE_MAGIC << CACHE_VERSION << quint32(fields.size())
+           << quint32(field[0][0].size()) << quint32(field[0].size()) << quint32(field.size());
+    for (cField *f : fields)
+        culcradar::write_Field(stream, *f);
+    if (!file.commit()) {
+        clogs("запись хранилища " + key + " не сохранена", "wrn", "");
+        return;
+    }
+    evict();
+}
+
+
+void resultCache::evict() {
+    QDir dir(m_dir);
+    QFileInfoList files = dir.entryInfoList(QStringList() << "*.bin", QDir::Files, QDir::Time);
+    qint64 size = 0;
+    for (const QFileInfo &info : files) size += info.size();
+    //список отсортирован от новых к старым
+    while ((size > m_capacity) && (files.size() > 1)) {
+        QFileInfo info = files.takeLast();
+        size -= info.size();
+        QFile::remove(info.absoluteFilePath());
+        clogs("запись хранилища " + info.completeBaseName() + " вытеснена", "", "");
+    }
+}
+
+
+void resultCache::setCapacity(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_capacity = qMax<qint64>(0, bytes);
+    evict();
+}
+
+
+qint64 resultCache::getCapacity() {
+    QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+
+qint64 resultCache::getSize() {
+    QMutexLocker locker(&m_mutex);
+    qint64 size = 0;
+    for (const QFileInfo &info : QDir(m_dir).entryInfoList(QStringList() << "*.bin", QDir::Files))
+        size += info.size();
+    return size;
+}
+
+
+int resultCache::getCount() {
+    QMutexLocker locker(&m_mutex);
+    return QDir(m_dir).entryList(QStringList() << "*.bin", QDir::Files).size();
+}
+
+
+void resultCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    for (const QFileInfo &info : QDir(m_dir).entryInfoList(QStringList() << "*.bin", QDir::Files))
+        QFile::remove(info.absoluteFilePath());
+}
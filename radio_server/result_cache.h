@@ -0,0 +1,44 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <QMutex>
+#include <QString>
+#include "Calc_Radar/CulcRadar.h"
+
+/*
+Хранилище результатов расчета на диске.
+Ключ - хеш содержимого задачи (модель, диапазон, поляризации, направление,
+тип радиопортрета, подстилающая поверхность). Значение - поля рассеяния после
+fft в двоичном виде (одно или два поля в режиме матрицы рассеяния). При превышении заданного объема удаляются записи,
+к которым дольше всего не обращались.
+*/
+
+class resultCache
+{
+public:
+    static resultCache &instance();
+
+    bool contains(const QString &key);
+    bool load(const QString &key, cFields fields);
+    void store(const QString &key, cFields fields);
+
+    void setCapacity(qint64 bytes);
+    qint64 getCapacity();
+    qint64 getSize();
+    int getCount();
+    void clear();
+
+private:
+    resultCache();
+    resultCache(const resultCache &) = delete;
+    resultCache &operator=(const resultCache &) = delete;
+
+    QString fileName(const QString &key);
+    void evict(); //удаление давно не использованных записей сверх объема
+
+    QMutex m_mutex;
+    QString m_dir;
+    qint64 m_capacity;
+};
+
+#endif // RESULT_CACHE_H
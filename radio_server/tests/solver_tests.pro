@@ -0,0 +1,34 @@
+QT -= gui
+QT = websockets
+QT += testlib
+QT += core5compat
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_solver
+INCLUDEPATH += ..
+
+SOURCES += \
+        tst_solver.cpp \
+        ../Calc_Radar/CulcRadar.cpp \
+        ../Calc_Radar/Radar_Wave.cpp \
+        ../Calc_Radar/mesh_decimation.cpp \
+        ../Calc_Radar/bvh.cpp \
+        ../Calc_Radar/sbr.cpp \
+        ../Calc_Radar/solver_kernels.cpp \
+        ../Calc_Radar/worker_pool.cpp \
+        ../calctools.cpp
+
+HEADERS += \
+    ../Calc_Radar/CulcRadar.h \
+    ../Calc_Radar/NUFFT.h \
+    ../Calc_Radar/Polygon.h \
+    ../Calc_Radar/Triangle.h \
+    ../Calc_Radar/mesh_decimation.h \
+    ../Calc_Radar/bvh.h \
+    ../Calc_Radar/sbr.h \
+    ../Calc_Radar/solver_kernels.h \
+    ../Calc_Radar/worker_pool.h \
+    ../calctools.h \
+    ../timer.h
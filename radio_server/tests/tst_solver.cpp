@@ -0,0 +1,368 @@
+#include <QtTest>
+#include <QFile>
+#include <cmath>
+#include "Calc_Radar/CulcRadar.h"
+#include "Calc_Radar/solver_kernels.h"
+#include "calctools.h"
+
+QScopedPointer<QFile> m_logFile;
+
+/*
+Сверка ускоренных путей ядра расчета с прямым суммированием по треугольникам
+на небольших фиксированных моделях: пластина с уголком (копланарные панели,
+модель симметрична относительно плоскости x = 0) и участок цилиндра.
+*/
+
+//ядро расчета с заданным числом потоков, без планировщика; в конце кванта
+//отмечает, применялись ли многоугольники и симметрия
+class testCore : public culcradar
+{
+public:
+    int threads = 2;
+    bool polygonOn = false;
+    bool symmetryOn = false;
+    QHash<uint, node> Node;
+    QHash<uint, edge> Edge;
+    int load(QJsonObject job) { return build_Model(job, Node, Edge); }
+protected:
+    int culc_Threads() override { return threads; }
+    void end_Slice() override {
+        polygonOn = polygonOn || m_polygonOn;
+        symmetryOn = symmetryOn || m_symmetryOn;
+    }
+};
+
+//треугольник по трем вершинам
+static void push_Triangle(QJsonArray &data, const rVect &a, const rVect &b, const rVect &c)
+{
+    for (rVect v : { a, b, c }) {
+        data.append(v.getX());
+        data.append(v.getY());
+        data.append(v.getZ());
+    }
+}
+
+//квадрат из двух треугольников; диагональ зеркальна относительно x = 0
+static void push_Quad(QJsonArray &data, const rVect &a, const rVect &b, const rVect &c, const rVect &d, bool left)
+{
+    if (left) {
+        push_Triangle(data, a, b, d);
+        push_Triangle(data, b, c, d);
+    }
+    else {
+        push_Triangle(data, a, b, c);
+        push_Triangle(data, a, c, d);
+    }
+}
+
+//вертикальная пластина 2 x 2 м в плоскости y = 0 и горизонтальная пластина
+//под ней: уголок из 256 треугольников
+static QJsonArray plate_Mesh()
+{
+    QJsonArray data;
+    for (int i = 0; i < 8; i++)
+        for (int j = 0; j < 8; j++) {
+            double x0 = -1 + 0.25 * i, x1 = x0 + 0.25, z0 = -1 + 0.25 * j, z1 = z0 + 0.25;
+            push_Quad(data, rVect(x0, 0, z0), rVect(x1, 0, z0), rVect(x1, 0, z1), rVect(x0, 0, z1), i < 4);
+            push_Quad(data, rVect(x0, -0.5 * (z0 + 1), -1), rVect(x1, -0.5 * (z0 + 1), -1),
+                      rVect(x1, -0.5 * (z1 + 1), -1), rVect(x0, -0.5 * (z1 + 1), -1), i < 4);
+        }
+    return data;
+}
+
+//участок цилиндра радиуса 1 м с осью Z: 800 треугольников
+static QJsonArray cylinder_Mesh()
+{
+    QJsonArray data;
+    for (int i = 0; i < 40; i++)
+        for (int j = 0; j < 10; j++) {
+            double a0 = -1.2 + 0.06 * i, a1 = a0 + 0.06, z0 = -1 + 0.2 * j, z1 = z0 + 0.2;
+            push_Quad(data, rVect(sin(a0), -cos(a0), z0), rVect(sin(a1), -cos(a1), z0),
+                      rVect(sin(a1), -cos(a1), z1), rVect(sin(a0), -cos(a0), z1), false);
+        }
+    return data;
+}
+
+//задача: освещенность - по нормалям треугольников к направлению падения In
+static QJsonObject make_Job(const QJsonArray &data, int band, const rVect &In, bool ax, bool ay, bool az)
+{
+    QJsonObject job;
+    job.insert("data", data);
+    QJsonArray visible;
+    for (int i = 0; i + 9 <= data.size(); i += 9) {
+        rVect v[3];
+        for (int k = 0; k < 3; k++)
+            v[k] = rVect(data[i + 3 * k].toDouble(), data[i + 3 * k + 1].toDouble(), data[i + 3 * k + 2].toDouble());
+        rVect n = (v[1] - v[0]) ^ (v[2] - v[0]);
+        visible.append(n * In < 0.);
+    }
+    job.insert("visibleTriangles", visible);
+    job.insert("freqBand", band);
+    job.insert("polarRadiation", 0);
+    job.insert("polarRecive", 0);
+    job.insert("typeAzimut", ax);
+    job.insert("typeLength", ay);
+    job.insert("typeAngle", az);
+    QJsonObject direct;
+    direct.insert("x", In.getX());
+    direct.insert("y", In.getY());
+    direct.insert("z", In.getZ());
+    job.insert("directVector", direct);
+    return job;
+}
+
+//поле после fft в порядке [iz][iy][ix]
+static vector<cVect> get_Field(testCore &core)
+{
+    vector<cVect> field;
+    for (int iz = 0; iz < core.getSizeEoutZ(); iz++)
+        for (int iy = 0; iy < core.getSizeEoutY(); iy++)
+            for (int ix = 0; ix < core.getSizeEoutX(); ix++)
+                field.push_back(core.getEout(ix, iy, iz));
+    return field;
+}
+
+//наибольшее отклонение поля от эталона относительно пика эталона
+static double deviation(const vector<cVect> &field, const vector<cVect> &reference)
+{
+    double err = 0., peak = 0.;
+    for (size_t m = 0; m < reference.size(); m++) {
+        cVect d = field[m] - reference[m];
+        err = std::max(err, d.norm());
+        peak = std::max(peak, cVect(reference[m]).norm());
+    }
+    return (peak > 0.) ? sqrt(err / peak) : 0.;
+}
+
+//поле задачи job (пустое при ошибке)
+static vector<cVect> solve(testCore &core, const QJsonObject &job)
+{
+    if ((core.load(job) != 0) || (core.culc_Eout() != 0)) return vector<cVect>();
+    return get_Field(core);
+}
+
+//единичный вектор направления падения
+static rVect unit(double x, double y, double z)
+{
+    rVect v(x, y, z);
+    return 1. / v.length() * v;
+}
+
+static rVect rotate_Z(const rVect &v, double deg)
+{
+    double cosa = cos(deg * Pi / 180.), sina = sin(deg * Pi / 180.);
+    return rVect(v.getX() * cosa - v.getY() * sina, v.getX() * sina + v.getY() * cosa, v.getZ());
+}
+
+class tst_solver : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void rcsMatchesPortrait();
+    void isarLocatesScatterers();
+    void rangeMatchesPerSample();
+    void float32WithinTolerance();
+    void deterministicAcrossThreads();
+    void nufftMatchesDirect();
+    void polygonsMatchTriangles();
+    void symmetryMatchesDirect();
+};
+
+void tst_solver::initTestCase()
+{
+    m_logFile.reset(new QFile("tst_solver.log"));
+    m_logFile.data()->open(QFile::WriteOnly | QFile::Text);
+}
+
+//ЭПР по азимуту (culc_Rcs) - портрет из одной точки на центральной частоте:
+//после fft поле умножено на sqrt(4*Pi), sigma = |E·Ein|^2
+void tst_solver::rcsMatchesPortrait()
+{
+    rVect In = unit(0.2, 1., 0.1);
+    QJsonObject job = make_Job(plate_Mesh(), 3, In, false, false, false);
+    QJsonObject sweep;
+    sweep.insert("from", 0);
+    sweep.insert("to", 30);
+    sweep.insert("step", 15);
+    job.insert("rcsSweep", sweep);
+    testCore core;
+    QCOMPARE(core.load(job), 0);
+    vector<double> sigma;
+    QCOMPARE(core.culc_Rcs(sigma), 0);
+    QCOMPARE(sigma.size(), size_t(3));
+    for (size_t a = 0; a < sigma.size(); a++) {
+        core.set_Direction(rotate_Z(In, 15. * a), 0, 0);
+        core.set_boolXYZ(false, false, false);
+        QCOMPARE(core.culc_Eout(), 0);
+        cVect E = core.getEout(0, 0, 0);
+        rVect Ein = core.getEin();
+        double portrait = std::norm(core.dot(E, Ein));
+        QVERIFY2(fabs(sigma[a] - portrait) <= 1e-9 * std::max(sigma[a], portrait),
+                 qPrintable(QString::number(sigma[a]) + " != " + QString::number(portrait)));
+        QVERIFY(sigma[a] > 0.);
+    }
+}
+
+//ISAR: изображение двух пластин 5 x 5 см имеет пики в их центрах, а между
+//ними на той же дальности - провал
+void tst_solver::isarLocatesScatterers()
+{
+    const double px[2] = { 0.6, -0.4 }, py[2] = { 0.2, -0.3 };
+    QJsonArray data;
+    for (int k = 0; k < 2; k++)
+        push_Quad(data, rVect(px[k] - 0.025, py[k], -0.025), rVect(px[k] + 0.025, py[k], -0.025),
+                  rVect(px[k] + 0.025, py[k], 0.025), rVect(px[k] - 0.025, py[k], 0.025), false);
+    QJsonObject job = make_Job(data, 4, rVect(0., 1., 0.), false, false, false);
+    QJsonObject isar;
+    isar.insert("from", -10);
+    isar.insert("to", 10);
+    isar.insert("step", 0.25);
+    isar.insert("pixel", 0.05);
+    isar.insert("size", 40);
+    job.insert("isar", isar);
+    testCore core;
+    QCOMPARE(core.load(job), 0);
+    vector<vector<double>> image;
+    double x0, y0, pixel;
+    QCOMPARE(core.culc_Isar(image, x0, y0, pixel), 0);
+    QCOMPARE(image.size(), size_t(40));
+    double peak = 0.;
+    for (auto &row : image)
+        for (double v : row) peak = std::max(peak, v);
+    auto at = [&](double x, double y) {
+        return image[lround((y - y0) / pixel)][lround((x - x0) / pixel)];
+    };
+    QVERIFY(peak > 0.);
+    for (int k = 0; k < 2; k++)
+        QVERIFY2(at(px[k], py[k]) >= 0.5 * peak, qPrintable(QString::number(at(px[k], py[k]) / peak)));
+    double gap = at(0.5 * (px[0] + px[1]), py[0]);
+    QVERIFY2(gap <= 0.2 * peak, qPrintable(QString::number(gap / peak)));
+}
+
+//портрет по дальности (culc_Range: блок частот за один проход по
+//треугольникам) - сумма эталонным ядром по каждой частоте и то же fft:
+//нормировка 1/sqrt(n), половины спектра меняются местами, множитель sqrt(4*Pi/n)
+void tst_solver::rangeMatchesPerSample()
+{
+    QJsonObject job = make_Job(cylinder_Mesh(), 4, unit(0.3, 1., 0.2), false, true, false);
+    testCore core;
+    vector<cVect> field = solve(core, job);
+    int n = core.getSizeEoutY();
+    QVERIFY(n > 1);
+    QCOMPARE(field.size(), size_t(n));
+    rVect Nin = core.get_Nin(), Nout = core.get_Nout(), Ein = core.getEin();
+    double stepW = 6. / (n * core.get_stepY());
+    const solverKernel *kernel = solverKernels::find("reference");
+    vector<cVect> spectrum(n);
+    for (int iy = 0; iy < n; iy++) {
+        double w = core.get_wave() - (iy - 0.5 * (n - 1)) * stepW;
+        for (size_t i = 0; i < core.getTriangleSize(); i++) {
+            triangle tr = core.get_Triangle(i);
+            if (!tr.getVisible()) continue;
+            complex<double> d;
+            kernel->sweep(tr, Nin, Nout, w, stepW, 1, &d);
+            spectrum[iy] = spectrum[iy] + d * tr.CulcPolarization(Nin, Nout, Ein);
+        }
+    }
+    vector<cVect> reference(n);
+    for (int k = 0; k < n; k++) {
+        cVect sum;
+        for (int j = 0; j < n; j++)
+            sum = sum + exp(OneI * (2. * Pi * k * j / n)) * spectrum[j];
+        reference[(k + n / 2) % n] = (sqrt(4. * Pi / n) / sqrt(1. * n)) * sum;
+    }
+    double err = deviation(field, reference);
+    QVERIFY2(err <= 1e-8, qPrintable(QString::number(err)));
+}
+
+//ядро float32: отклонение от расчета в double не больше 1e-3, и так же
+//его оценивает сверка с эталоном в самой задаче
+void tst_solver::float32WithinTolerance()
+{
+    QJsonObject job = make_Job(cylinder_Mesh(), 4, unit(0.3, 1., 0.2), true, true, true);
+    testCore direct, reduced;
+    vector<cVect> reference = solve(direct, job);
+    job.insert("precision", "float32");
+    vector<cVect> field = solve(reduced, job);
+    QVERIFY(!reference.empty());
+    QCOMPARE(field.size(), reference.size());
+    double err = deviation(field, reference);
+    QVERIFY2(err <= 1e-3, qPrintable(QString::number(err)));
+    QVERIFY(reduced.get_PrecisionError() >= 0.);
+    QVERIFY(reduced.get_PrecisionError() <= 1e-3);
+}
+
+//воспроизводимый расчет побитно одинаков при любом числе потоков
+//(сетка по углам и частоте и портрет по дальности)
+void tst_solver::deterministicAcrossThreads()
+{
+    for (bool range : { false, true }) {
+        QJsonObject job = make_Job(cylinder_Mesh(), 3, unit(0.3, 1., 0.2), !range, true, !range);
+        job.insert("deterministic", true);
+        testCore single;
+        single.threads = 1;
+        vector<cVect> reference = solve(single, job);
+        QVERIFY(!reference.empty());
+        for (int threads : { 2, 3, 5 }) {
+            testCore core;
+            core.threads = threads;
+            vector<cVect> field = solve(core, job);
+            QCOMPARE(field.size(), reference.size());
+            QVERIFY(memcmp(field.data(), reference.data(), field.size() * sizeof(cVect)) == 0);
+        }
+    }
+}
+
+//неравномерное fft с допуском 1e-3 (сетка по углу места и частоте) - прямое
+//суммирование; с подстилающей поверхностью задача отклоняется
+void tst_solver::nufftMatchesDirect()
+{
+    QJsonObject job = make_Job(plate_Mesh(), 3, unit(0.3, 1., 0.2), false, true, true);
+    testCore direct, nufft;
+    vector<cVect> reference = solve(direct, job);
+    job.insert("engine", "nufft");
+    job.insert("accuracy", 1e-3);
+    vector<cVect> field = solve(nufft, job);
+    QCOMPARE(nufft.get_Engine(), QString("nufft"));
+    QCOMPARE(field.size(), reference.size());
+    double err = deviation(field, reference);
+    QVERIFY2(err <= 1e-3, qPrintable(QString::number(err)));
+    job.insert("pplane", true);
+    testCore ground;
+    QCOMPARE(ground.load(job), 11);
+}
+
+//копланарные треугольники пластин, объединенные в многоугольники, дают то же поле
+void tst_solver::polygonsMatchTriangles()
+{
+    QJsonObject job = make_Job(plate_Mesh(), 3, unit(0.3, 1., 0.2), true, true, true);
+    testCore direct, merged;
+    vector<cVect> reference = solve(direct, job);
+    job.insert("coplanar", true);
+    vector<cVect> field = solve(merged, job);
+    QVERIFY(merged.polygonOn);
+    QCOMPARE(field.size(), reference.size());
+    double err = deviation(field, reference);
+    QVERIFY2(err <= 1e-6, qPrintable(QString::number(err)));
+}
+
+//направления в плоскости симметрии x = 0 (падение в ней, сетка по углу места
+//и частоте): половина пар треугольников не считается, поле то же
+void tst_solver::symmetryMatchesDirect()
+{
+    QJsonObject job = make_Job(plate_Mesh(), 3, unit(0., 1., 0.3), false, true, true);
+    testCore direct, mirrored;
+    vector<cVect> reference = solve(direct, job);
+    job.insert("symmetry", true);
+    vector<cVect> field = solve(mirrored, job);
+    QVERIFY(mirrored.symmetryOn);
+    QCOMPARE(field.size(), reference.size());
+    double err = deviation(field, reference);
+    QVERIFY2(err <= 1e-9, qPrintable(QString::number(err)));
+}
+
+QTEST_APPLESS_MAIN(tst_solver)
+
+#include "tst_solver.moc"
@@ -5,6 +5,9 @@
 #include <chrono>
 #include <functional>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 class Timer
 {
@@ -20,23 +23,36 @@ public:
      * Starting the timer.
      */
     void start() {
+        stop();
         m_running = true;
-        m_thread = std::thread([&]() {
+        m_thread = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(m_mutex);
             while (m_running) {
                 auto delta = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_interval);
+                lock.unlock();
                 m_func();
-                std::this_thread::sleep_until(delta);
+                lock.lock();
+                m_wake.wait_until(lock, delta, [this]() { return !m_running; });
             }
         });
-        m_thread.detach();
     }
 
     /*
-     *  Stopping the timer and destroys the thread.
+     *  Stopping the timer and joins the thread: after stop()
+     *  the function is not called any more.
      */
     void stop() {
-        m_running = false;
-        m_thread.~thread();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_wake.notify_all();
+        if (m_thread.joinable()) {
+            if (m_thread.get_id() == std::this_thread::get_id())
+                m_thread.detach();
+            else
+                m_thread.join();
+        }
     }
 
     /*
@@ -100,12 +116,15 @@ private:
     // Function to be executed fater interval
     std::function<void(void)> m_func;
     // Timer interval in milliseconds
-    long m_interval;
+    long m_interval = 1000;
 
     // Thread timer is running into
     std::thread m_thread;
+    // Wakes the thread on stop
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
     // Status if timer is running
-    bool m_running = false;
+    std::atomic<bool> m_running{false};
 };
 
 #endif // TIMER_H
@@ -2,6 +2,10 @@
 #include <QtWebSockets>
 #include "calctools.h"
 #include "radar_thread.h"
+#include "radar_scheduler.h"
+#include "result_cache.h"
+#include "Calc_Radar/solver_kernels.h"
+#include <QCryptographicHash>
 
 
 //конструктор
@@ -14,6 +18,12 @@ WebServer::WebServer(quint16 port, QObject *parent)
     clogs("версия приложения 1.0", "", "");
     clogs("АО НЦПЭ 2022, все права защищены", "", "");
     clogs("идет прослушивание порта " + QString::number(port), "", "");
+    //самопроверка ядер расчета на вырожденных случаях дифракционного интеграла
+    double kernelError = solverKernels::selfCheck();
+    if (kernelError > SELF_CHECK_TOLERANCE)
+        clogs("самопроверка ядер расчета не пройдена: отклонение " + QString::number(kernelError, 'g', 3), "wrn", "");
+    else
+        clogs("самопроверка ядер расчета: отклонение " + QString::number(kernelError, 'g', 3), "", "");
 
     connect(m_pWebSocketServer, &QWebSocketServer::newConnection, this,
             &WebServer::onNewConnection);
@@ -276,9 +286,12 @@ void WebServer::loadRadarData(QJsonDocument &doc, QJsonObject &jsonObject, QWebS
         (clientAI *)pSender->property("client_info").toULongLong();
     int size = task_list.size();
     uint id = GetCoreID(doc);
+    QString hash = GetJobHash(jsonObject);
     for (int i = 0; i < size; i++) {
-       if (task_list.at(i)->getClientRadar()->id == clientInfo->id) { //канал связи совпал
-          if (task_list.at(i)->getModelId() == id) { //входные данные совпали
+       if (task_list.at(i)->hasSubscriber(clientInfo)) { //канал связи совпал
+          if (task_list.at(i)->getJobHash() == hash) { //входные данные совпали
+              //результат уже передан: повторная задача получает его при подписке
+              if (task_list.at(i)->isPublished()) break;
               clogs("ресурс [" + clientInfo->id + "] не выделен", "", "");
               QString QAnswer;
               QAnswer = "задача для oбъекта " + QString::number(jsonObject.value("id").toInt());
@@ -289,9 +302,25 @@ void WebServer::loadRadarData(QJsonDocument &doc, QJsonObject &jsonObject, QWebS
           else {
               //socketDisconnected();
               task_kill(pSender); //другие входные данные, удаление старой задачи
+              break;
           }
        }
     }
+
+    //такая же задача уже считается для другого клиента: подписка на ее результат.
+    //результаты, переданные до подписки, повторяются подписчику; остановленная
+    //без результата задача не подходит - считается новая
+    for (int i = 0; i < task_list.size(); i++) {
+       radarCore *Core = task_list.at(i);
+       if ((Core->getJobHash() == hash) && (Core->isRun() || Core->isPublished())) {
+          bool published = Core->subscribe(clientInfo, pSender, jsonObject.value("id").toInt());
+          clogs("клиент [" + clientInfo->id + "] присоединен к задаче " + hash, "", "");
+          if (!published)
+              webServerAnswer("такая же задача уже выполняется, результат будет передан по ее завершении",
+                              pSender);
+          return;
+       }
+    }
     QTest::qSleep(1000);
     //создание потока с вычислительным ядром
     QThread *pthread_radar = new QThread(this);
@@ -304,7 +333,7 @@ void WebServer::loadRadarData(QJsonDocument &doc, QJsonObject &jsonObject, QWebS
         connect(pCore, &radarCore::finished, pCore, &radarCore::deleteLater);
         connect(pthread_radar, &QThread::finished, pthread_radar, &QThread::deleteLater);
 
-        connect(pCore, &radarCore::task_kill, this, &WebServer::kill_task);
+        connect(pCore, &radarCore::task_finished, this, &WebServer::kill_task);
         connect(pCore, &radarCore::send_text, this, &WebServer::message_calc_radar);
         connect(pCore, &radarCore::send_progress_bar, this, &WebServer::message_calc_radar);
         connect(pCore, &radarCore::send_result, this, &WebServer::send_calc_radar_result);
@@ -314,6 +343,8 @@ void WebServer::loadRadarData(QJsonDocument &doc, QJsonObject &jsonObject, QWebS
         pCore->setRadarParam(doc, clientInfo, pSender);
         pCore->id = jsonObject.value("id").toInt();
         pCore->setModelId(id);
+        pCore->setJobHash(hash);
+        pCore->subscribe(clientInfo, pSender, pCore->id);
         pthread_radar->start();
 
         task_list.push_back(pCore);
@@ -426,6 +457,33 @@ void WebServer::handlerCmd(QString command, QJsonArray *params,
           }
           webServerAnswer(QAnswer, pSender);
         }
+        else if (params->at(0).toString() == "slots") { //число вычислительных слотов
+          radarScheduler &scheduler = radarScheduler::instance();
+          if ((params->size() > 1) && (params->at(1).toString().toInt() > 0)) {
+              scheduler.setSlots(params->at(1).toString().toInt());
+              clogs("число вычислительных слотов " + QString::number(scheduler.getSlots()), "", "");
+          }
+          webServerAnswer("Слотов: " + QString::number(scheduler.getSlots()) +
+                              " занято: " + QString::number(scheduler.getBusy()) +
+                              " в очереди: " + QString::number(scheduler.getWaiting()),
+                          pSender);
+        }
+        else if (params->at(0).toString() == "cache") { //хранилище результатов
+          resultCache &cache = resultCache::instance();
+          if ((params->size() > 1) && (params->at(1).toString() == "clear")) {
+              cache.clear();
+              clogs("хранилище результатов очищено", "", "");
+          }
+          else if ((params->size() > 1) && (params->at(1).toString().toLongLong() > 0)) {
+              cache.setCapacity(params->at(1).toString().toLongLong() * 1024 * 1024);
+              clogs("объем хранилища результатов " +
+                    QString::number(cache.getCapacity() / (1024 * 1024)) + " Мб", "", "");
+          }
+          webServerAnswer("Хранилище результатов: записей " + QString::number(cache.getCount()) +
+                              ", " + QString::number(cache.getSize() / (1024 * 1024)) + " из " +
+                              QString::number(cache.getCapacity() / (1024 * 1024)) + " Мб",
+                          pSender);
+        }
         else if (params->at(0).toString() == "pause") { //поставить вычисление на паузу
             QString QAnswer;
             QAnswer = " пауза для: ";
@@ -585,10 +643,17 @@ void WebServer::setCmd(QString &message, QWebSocket *pSender, int &cmd_id) {
     for (int i = 0; i < size; i++) {
         clientAI *clientInfo =
             (clientAI *)pSender->property("client_info").toULongLong();
-        if (task_list.at(i)->getClientRadar()->id == clientInfo->id) {
+        if (task_list.at(i)->hasSubscriber(clientInfo)) {
             QAnswer = QAnswer + QString::number(i) + ". " + clientInfo->login +
                     " [ " + clientInfo->id + " ]" + " Статус: [OK] ";
             webServerAnswer(QAnswer, pSender);
+            //общей задачей управляет только ее владелец
+            if (((cmd_id == 2) || (cmd_id == 3)) && !task_list.at(i)->isOwner(clientInfo)) {
+               QAnswer = "задача выполняется и для других клиентов, пауза и продолжение "
+                         "доступны только ее владельцу";
+               webServerAnswer(QAnswer, pSender);
+               continue;
+            }
             if (cmd_id == 2) {
                QAnswer = "приостановка вычислений";
                webServerAnswer(QAnswer, pSender);
@@ -616,12 +681,14 @@ void WebServer::setCmd(QString &message, QWebSocket *pSender, int &cmd_id) {
     }
 }
 
-//слот уничтожения задач вычислительному ядру
-void WebServer::kill_task(QWebSocket *pSender) {
-    task_kill(pSender);
+//слот удаления завершенной задачи из списка задач
+void WebServer::kill_task(radarCore *Core) {
+    //ядро к этому моменту может быть уже удалено, указатель только сравнивается
+    if (task_list.removeAll(Core) > 0)
+        clogs("задача завершена, в работе " + QString::number(task_list.size()), "", "");
 }
 
-//процедура уничтожения задач и вычислительного ядра
+//процедура отписки клиента от задач и уничтожения задач без подписчиков
 bool WebServer::task_kill(QWebSocket *pSender) {
     QString QAnswer;
     int size = task_list.size();
@@ -633,19 +700,32 @@ bool WebServer::task_kill(QWebSocket *pSender) {
     clientAI *clientInfo =
         (clientAI *)pSender->property("client_info").toULongLong();
     int n = 0;
+    QList<radarCore *> tasks = task_list;
     for (int i = 0; i < size; i++) {
-        if (task_list.at(i)->getClientRadar()->id == clientInfo->id) {
-            radarCore *Core = task_list.at(i);
+        radarCore *Core = tasks.at(i);
+        if (Core->hasSubscriber(clientInfo)) {
             QAnswer = QString::number(n) + ". " + clientInfo->login +
                     " [<b>" + clientInfo->id + "</b>]";
             webServerAnswer(QAnswer, pSender);
+            bool owner = Core->isOwner(clientInfo);
+            if (Core->unsubscribe(pSender) > 0) {
+                //задача нужна другим клиентам и продолжает считаться;
+                //пауза ушедшего владельца снимается
+                if (owner && Core->isPaused()) Core->continue_core();
+                clogs("клиент [" + clientInfo->id + "] отключен от задачи " +
+                      Core->getJobHash(), "", "");
+                QAnswer = "подписка на результат отменена";
+                webServerAnswer(QAnswer, pSender);
+                n++;
+                continue;
+            }
             clogs("освобождение ресурса [" + clientInfo->id + "]", "", "");
             QAnswer = "ресурс освобожден";
             webServerAnswer(QAnswer, pSender);
-            task_list.at(i)->setRunning(false);
-            task_list.at(i)->stop();
+            Core->setRunning(false);
+            Core->stop();
 //            QTest::qSleep(1000);
-            task_list.at(i)->finished();
+            Core->finished();
             task_list.removeAll(Core);
             //Core->deleteLater();
         }
@@ -675,6 +755,16 @@ void WebServer::send_calc_radar_result(QString doc, QWebSocket *Client) {
     webServerAnswer("вычисления окончены", Client);
 }
 
+//хеш содержимого задачи: модель и параметры расчета без служебных полей.
+//ключи QJsonObject упорядочены, поэтому компактная запись канонична
+QString WebServer::GetJobHash(const QJsonObject &jsonObject) {
+    QJsonObject job = jsonObject;
+    job.remove("id");
+    job.remove("type");
+    QByteArray data = QJsonDocument(job).toJson(QJsonDocument::Compact);
+    return QString(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+}
+
 //генерирование идентификатора исходных данных
 uint WebServer::GetCoreID(QJsonDocument &doc){
    QJsonObject jsonObject = doc.object();
@@ -25,12 +25,13 @@ public:
   bool task_kill(QWebSocket *pSender);
   QString GetRandomString();
   uint GetCoreID(QJsonDocument &doc);
+  QString GetJobHash(const QJsonObject &jsonObject);
 
 private slots:
   void onNewConnection();
   void socketDisconnected();
   void processMessage(const QString &message);
-  void kill_task(QWebSocket *pSender);
+  void kill_task(radarCore *Core);
   //  void processBinaryMessage(QByteArray message);
 
 public slots: